@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+// first block of a growing arena
+#define ARENA_MIN_SIZE 65536
+
+// make room for size bytes in all, so allocations up to there do not move base
+void arena_reserve(struct arena *a, size_t size) {
+    if (size <= a->size)
+        return;
+    if (size > (size_t)UINT32_MAX + 1) {
+        fprintf(stderr, "hostgen: more than 4 GiB of names to keep\n");
+        exit(1);
+    }
+    char *base = realloc(a->base, size);
+    if (base == NULL) {
+        perror("hostgen: malloc");
+        exit(1);
+    }
+    a->base = base;
+    a->size = size;
+}
+
+// reserve len bytes, return their offset; the arena grows as needed, up to
+// 4 GiB in all
+uint32_t arena_alloc(struct arena *a, size_t len) {
+    if (a->used + len > a->size) {
+        size_t size = a->size ? a->size : ARENA_MIN_SIZE;
+        while (size < a->used + len)
+            size *= 2;
+        if (size > (size_t)UINT32_MAX + 1 && a->used + len <= (size_t)UINT32_MAX + 1)
+            size = (size_t)UINT32_MAX + 1;
+        arena_reserve(a, size);
+    }
+    uint32_t offset = a->used;
+    a->used += len;
+    return offset;
+}
+
+// copy len bytes into the arena, return their offset
+uint32_t arena_push(struct arena *a, const void *data, size_t len) {
+    uint32_t offset = arena_alloc(a, len);
+    memcpy(a->base + offset, data, len);
+    return offset;
+}
+
+// drop every allocation and release the memory
+void arena_free(struct arena *a) {
+    free(a->base);
+    a->base = NULL;
+    a->used = 0;
+    a->size = 0;
+}
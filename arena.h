@@ -0,0 +1,38 @@
+#ifndef HOSTGEN_ARENA_H
+#define HOSTGEN_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// bump allocator for strings and other small records that live as long as the
+// arena does. allocations are addressed by 32-bit offsets from base, which stay
+// valid when the arena grows and moves, and everything is released at once
+struct arena {
+    char *base;
+    size_t used, size;
+};
+
+// reserve len bytes, return their offset; the arena grows as needed, up to
+// 4 GiB in all
+uint32_t arena_alloc(struct arena *a, size_t len);
+
+// copy len bytes into the arena, return their offset
+uint32_t arena_push(struct arena *a, const void *data, size_t len);
+
+// make room for size bytes in all, so allocations up to there do not move base
+void arena_reserve(struct arena *a, size_t size);
+
+// drop every allocation but keep the memory for reuse
+static inline void arena_reset(struct arena *a) {
+    a->used = 0;
+}
+
+// drop every allocation and release the memory
+void arena_free(struct arena *a);
+
+// address of the allocation at an offset; only valid until the arena grows
+static inline char *arena_at(const struct arena *a, uint32_t offset) {
+    return a->base + offset;
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include <string.h>
+
+#include "chacha.h"
+
+// one 32-bit lane per block; gcc lowers this to SSE2/NEON registers
+typedef uint32_t vec4 __attribute__((vector_size(16)));
+
+#define ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER_ROUND(a, b, c, d) \
+    a += b; d ^= a; d = ROTL(d, 16); \
+    c += d; b ^= c; b = ROTL(b, 12); \
+    a += b; d ^= a; d = ROTL(d, 8); \
+    c += d; b ^= c; b = ROTL(b, 7);
+
+// little-endian load
+static uint32_t load32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// key the generator with 32 bytes of key and 8 bytes of nonce
+void chacha_rng_init(struct chacha_rng *rng, const uint8_t seed[40]) {
+    static const uint8_t sigma[16] = "expand 32-byte k";
+    for (int i = 0; i < 4; i++)
+        rng->input[i] = load32(sigma + i * 4);
+    for (int i = 0; i < 8; i++)
+        rng->input[4 + i] = load32(seed + i * 4);
+    // words 12 and 13 are the 64-bit block counter, 14 and 15 the nonce
+    rng->input[12] = 0;
+    rng->input[13] = 0;
+    rng->input[14] = load32(seed + 32);
+    rng->input[15] = load32(seed + 36);
+    rng->pos = CHACHA_BUF_WORDS;
+}
+
+// compute the next four blocks of keystream into rng->buf
+void chacha_rng_refill(struct chacha_rng *rng) {
+    vec4 x[16], in[16];
+    uint64_t counter = rng->input[12] | (uint64_t)rng->input[13] << 32;
+
+    for (int i = 0; i < 16; i++)
+        in[i] = (vec4){rng->input[i], rng->input[i], rng->input[i], rng->input[i]};
+    for (int b = 0; b < 4; b++) {
+        in[12][b] = (uint32_t)(counter + b);
+        in[13][b] = (uint32_t)((counter + b) >> 32);
+    }
+    memcpy(x, in, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    // lanes hold blocks; store them one after the other in keystream order
+    for (int i = 0; i < 16; i++) {
+        x[i] += in[i];
+        for (int b = 0; b < 4; b++)
+            rng->buf[b * 16 + i] = x[i][b];
+    }
+
+    counter += 4;
+    rng->input[12] = (uint32_t)counter;
+    rng->input[13] = (uint32_t)(counter >> 32);
+    rng->pos = 0;
+}
@@ -0,0 +1,31 @@
+#ifndef HOSTGEN_CHACHA_H
+#define HOSTGEN_CHACHA_H
+
+#include <stdint.h>
+
+// keystream words buffered per refill; four 64-byte blocks computed side by side
+#define CHACHA_BUF_WORDS 64
+
+// ChaCha20 keystream used as a random number generator
+struct chacha_rng {
+    uint32_t input[16];
+    uint32_t buf[CHACHA_BUF_WORDS];
+    unsigned int pos;
+};
+
+// key the generator with 32 bytes of key and 8 bytes of nonce
+void chacha_rng_init(struct chacha_rng *rng, const uint8_t seed[40]);
+
+// compute the next four blocks of keystream into rng->buf
+void chacha_rng_refill(struct chacha_rng *rng);
+
+// next 64 bits of keystream
+static inline uint64_t chacha_rng_next(struct chacha_rng *rng) {
+    if (rng->pos >= CHACHA_BUF_WORDS)
+        chacha_rng_refill(rng);
+    uint64_t result = rng->buf[rng->pos] | (uint64_t)rng->buf[rng->pos + 1] << 32;
+    rng->pos += 2;
+    return result;
+}
+
+#endif
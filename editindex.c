@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "editindex.h"
+
+// bit i of peq[c] is set where the pattern has byte c at position i
+struct pattern {
+    uint64_t peq[256];
+    uint64_t high;
+    size_t len;
+};
+
+// what to do with each deletion variant of a name
+struct variant_visitor {
+    const char *name;
+    size_t len;
+    bool (*visit)(struct variant_visitor *v, uint64_t hash);
+    struct edit_index *index;
+    const struct name_set *set;
+    const struct pattern *pattern;
+    uint32_t offset;
+};
+
+// prepare a pattern of at most 64 bytes for edit_distance()
+static void pattern_init(struct pattern *p, const char *s, size_t len) {
+    memset(p->peq, 0, sizeof(p->peq));
+    for (size_t i = 0; i < len; i++)
+        p->peq[(unsigned char)s[i]] |= 1ULL << i;
+    p->high = len > 0 ? 1ULL << (len - 1) : 0;
+    p->len = len;
+}
+
+// Levenshtein distance between the pattern and s, computed a column at a time
+// with the pattern's rows as bits of a word (Myers/Hyyro bit-vector algorithm)
+static unsigned int edit_distance(const struct pattern *p, const char *s, size_t len) {
+    uint64_t pv = ~0ULL, mv = 0;
+    unsigned int score = p->len;
+    if (p->len == 0)
+        return len;
+    for (size_t j = 0; j < len; j++) {
+        uint64_t eq = p->peq[(unsigned char)s[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & p->high)
+            score++;
+        else if (mh & p->high)
+            score--;
+        // the top row of the matrix is 0, 1, 2, ... so each column starts one up
+        ph = ph << 1 | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+// hash of name without the characters whose bits are set in deleted; FNV-1a
+// with a final mix, since the table is indexed by the top bits
+static uint64_t variant_hash(const char *name, size_t len, uint64_t deleted) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < len; i++)
+        if (!(deleted >> i & 1))
+            hash = (hash ^ (unsigned char)name[i]) * 0x100000001b3;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccd;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// visit every variant of the name with up to k more characters deleted at or
+// after start; returns true if a visit asked to stop. deleting either of two
+// equal neighbours gives the same string, so only the first is tried
+static bool for_each_variant(struct variant_visitor *v, uint64_t deleted, size_t start, unsigned int k) {
+    if (v->visit(v, variant_hash(v->name, v->len, deleted)))
+        return true;
+    for (size_t i = start; k > 0 && i < v->len; i++) {
+        if (i > start && v->name[i] == v->name[i - 1])
+            continue;
+        if (for_each_variant(v, deleted | 1ULL << i, i + 1, k - 1))
+            return true;
+    }
+    return false;
+}
+
+// put a slot into the table at or after its home position
+static void edit_index_place(uint64_t *slots, unsigned int bits, uint64_t slot) {
+    size_t mask = ((size_t)1 << bits) - 1, pos = (slot >> 32) >> (32 - bits);
+    while (slots[pos] != 0)
+        pos = (pos + 1) & mask;
+    slots[pos] = slot;
+}
+
+// double the table; home positions come from the stored hash halves
+static void edit_index_grow(struct edit_index *index) {
+    unsigned int bits = index->bits + 1;
+    uint64_t *slots = calloc((size_t)1 << bits, sizeof(slots[0]));
+    if (bits > 32 || slots == NULL) {
+        perror("hostgen: malloc");
+        exit(1);
+    }
+    for (size_t i = 0; i < (size_t)1 << index->bits; i++)
+        if (index->slots[i] != 0)
+            edit_index_place(slots, bits, index->slots[i]);
+    free(index->slots);
+    index->slots = slots;
+    index->bits = bits;
+}
+
+// set up an empty index answering for distance k (1 to EDIT_INDEX_MAX_DISTANCE)
+void edit_index_init(struct edit_index *index, unsigned int k) {
+    index->bits = 12;
+    index->slots = calloc((size_t)1 << index->bits, sizeof(index->slots[0]));
+    if (index->slots == NULL) {
+        perror("hostgen: malloc");
+        exit(1);
+    }
+    index->count = 0;
+    index->k = k;
+}
+
+// file the name being added under one of its variants
+static bool visit_add(struct variant_visitor *v, uint64_t hash) {
+    struct edit_index *index = v->index;
+    // keep the load factor at or below a half
+    if (++index->count > (size_t)1 << (index->bits - 1))
+        edit_index_grow(index);
+    edit_index_place(index->slots, index->bits, (hash >> 32) << 32 | (v->offset + 1));
+    return false;
+}
+
+// add the name stored at pool offset name in set
+void edit_index_add(struct edit_index *index, const struct name_set *set, uint32_t name) {
+    struct variant_visitor v = {name_set_str(set, name), name_set_len(set, name), visit_add, index};
+    v.offset = name;
+    for_each_variant(&v, 0, 0, index->k);
+}
+
+// compare the candidate with every name filed under one of its variants; a
+// shared variant only bounds the distance by 2k, so each is checked
+static bool visit_within(struct variant_visitor *v, uint64_t hash) {
+    const struct edit_index *index = v->index;
+    size_t mask = ((size_t)1 << index->bits) - 1;
+    uint64_t tag = hash >> 32;
+    for (size_t pos = tag >> (32 - index->bits); index->slots[pos] != 0; pos = (pos + 1) & mask) {
+        if (index->slots[pos] >> 32 != tag)
+            continue;
+        uint32_t other = (uint32_t)index->slots[pos] - 1;
+        size_t other_len = name_set_len(v->set, other);
+        if (other_len + index->k < v->len || v->len + index->k < other_len)
+            continue;
+        if (edit_distance(v->pattern, name_set_str(v->set, other), other_len) <= index->k)
+            return true;
+    }
+    return false;
+}
+
+// whether any indexed name is within k edits of name (at most 64 bytes)
+bool edit_index_within(const struct edit_index *index, const struct name_set *set, const char *name, size_t len) {
+    struct pattern p;
+    struct variant_visitor v = {name, len, visit_within, (struct edit_index *)index, set, &p};
+    pattern_init(&p, name, len);
+    return for_each_variant(&v, 0, 0, index->k);
+}
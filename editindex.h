@@ -0,0 +1,37 @@
+#ifndef HOSTGEN_EDITINDEX_H
+#define HOSTGEN_EDITINDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nameset.h"
+
+// largest distance an edit_index answers for; each name is indexed under every
+// way of deleting up to that many characters, which grows as length^distance
+#define EDIT_INDEX_MAX_DISTANCE 3
+
+// index of the names in a name_set for finding those within k edits of a
+// candidate. two strings at most k edits apart can both be cut down to a common
+// string by deleting at most k characters from each, so every name is filed
+// under the hashes of all its deletion variants, and a candidate only has to be
+// compared with the names sharing one of its own variants. slots hold the upper
+// half of a variant's hash above name offset + 1; the table is indexed by the
+// top bits of the hash, so it can grow without rehashing any names
+struct edit_index {
+    uint64_t *slots;
+    unsigned int bits;
+    size_t count;
+    unsigned int k;
+};
+
+// set up an empty index answering for distance k (1 to EDIT_INDEX_MAX_DISTANCE)
+void edit_index_init(struct edit_index *index, unsigned int k);
+
+// add the name stored at pool offset name in set
+void edit_index_add(struct edit_index *index, const struct name_set *set, uint32_t name);
+
+// whether any indexed name is within k edits of name (at most 64 bytes)
+bool edit_index_within(const struct edit_index *index, const struct name_set *set, const char *name, size_t len);
+
+#endif
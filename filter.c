@@ -0,0 +1,255 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "filter.h"
+
+// construction attempts before giving up; each fails with probability well
+// under one in a thousand
+#define FILTER_MAX_ATTEMPTS 100
+
+// exit on a failed allocation
+static void *filter_alloc(size_t size) {
+    void *p = calloc(size, 1);
+    if (p == NULL) {
+        perror("hostgen: malloc");
+        exit(1);
+    }
+    return p;
+}
+
+// murmur3 64-bit finalizer
+static inline uint64_t murmur64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53;
+    h ^= h >> 33;
+    return h;
+}
+
+// next seed to try after a failed construction
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// the three fingerprint positions of a hashed key: one in each of three
+// consecutive segments, starting at a segment chosen by the hash's top bits
+static inline void filter_positions(const struct filter_header *h, uint64_t hash, uint32_t pos[3]) {
+    uint64_t hi = (uint64_t)(((unsigned __int128)hash * h->segment_count_length) >> 64);
+    pos[0] = hi;
+    pos[1] = (pos[0] + h->segment_length) ^ ((hash >> 18) & h->segment_length_mask);
+    pos[2] = (pos[0] + 2 * h->segment_length) ^ (hash & h->segment_length_mask);
+}
+
+// fingerprint of a hashed key, of fingerprint_bits bits
+static inline uint16_t filter_fingerprint(const struct filter_header *h, uint64_t hash) {
+    return (hash ^ hash >> 32) & ((1U << h->fingerprint_bits) - 1);
+}
+
+// key of a hostname, already folded with name_fold(), for filter_contains()
+uint64_t filter_key(const char *name, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char)name[i]) * 0x100000001b3;
+    return murmur64(hash);
+}
+
+// order keys for qsort()
+static int compare_keys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// size the segments and fingerprint array for count keys
+static void filter_dimensions(struct filter_header *h, size_t count) {
+    // segments shrink relative to the array as it grows, keeping the three
+    // positions of a key close together for the cache
+    h->segment_length = count == 0 ? 4 : 1U << (int)floor(log((double)count) / log(3.33) + 2.25);
+    if (h->segment_length > 262144)
+        h->segment_length = 262144;
+    h->segment_length_mask = h->segment_length - 1;
+    double size_factor = count <= 1 ? 0 : fmax(1.125, 0.875 + 0.25 * log(1000000.0) / log((double)count));
+    uint32_t capacity = count <= 1 ? 0 : (uint32_t)round(count * size_factor);
+    uint32_t segments = (capacity + h->segment_length - 1) / h->segment_length;
+    uint32_t segment_count = segments > 2 ? segments - 2 : 1;
+    h->array_length = (segment_count + 2) * h->segment_length;
+    h->segment_count_length = segment_count * h->segment_length;
+}
+
+// build a filter over keys (which are sorted and deduplicated in place) with
+// fingerprints of 8 or 16 bits, starting from the given seed, and write it to
+// file; returns false on a write error
+bool filter_build(uint64_t *keys, size_t count, unsigned int fingerprint_bits, uint64_t seed, FILE *file) {
+    struct filter_header h = {FILTER_MAGIC, fingerprint_bits};
+
+    // the peeling below needs distinct keys
+    qsort(keys, count, sizeof(keys[0]), compare_keys);
+    size_t distinct = 0;
+    for (size_t i = 0; i < count; i++)
+        if (distinct == 0 || keys[i] != keys[distinct - 1])
+            keys[distinct++] = keys[i];
+    count = distinct;
+    if (count >= UINT32_MAX) {
+        fprintf(stderr, "hostgen: too many names for one filter\n");
+        exit(1);
+    }
+    h.key_count = count;
+    filter_dimensions(&h, count);
+
+    uint32_t capacity = h.array_length;
+    uint16_t *fingerprints = filter_alloc(capacity * sizeof(uint16_t));
+    uint64_t *order = filter_alloc((count + 1) * sizeof(uint64_t));
+    uint8_t *order_pos = filter_alloc(count + 1);
+    uint32_t *alone = filter_alloc(capacity * sizeof(uint32_t));
+    uint8_t *t2count = filter_alloc(capacity);
+    uint64_t *t2hash = filter_alloc(capacity * sizeof(uint64_t));
+
+    // hashes are bucketed by their top bits, roughly by segment, before being
+    // added, so the counting pass walks the arrays nearly in order
+    unsigned int block_bits = 1;
+    while ((1U << block_bits) < h.segment_count_length / h.segment_length)
+        block_bits++;
+    uint32_t block = 1U << block_bits, *start = filter_alloc(block * sizeof(uint32_t));
+
+    for (int attempt = 0;; attempt++) {
+        if (attempt == FILTER_MAX_ATTEMPTS) {
+            fprintf(stderr, "hostgen: cannot build filter\n");
+            exit(1);
+        }
+        h.seed = splitmix64(&seed);
+        memset(order, 0, count * sizeof(uint64_t));
+        memset(t2count, 0, capacity);
+        memset(t2hash, 0, capacity * sizeof(uint64_t));
+        order[count] = 1;
+
+        for (uint32_t i = 0; i < block; i++)
+            start[i] = ((uint64_t)i * count) >> block_bits;
+        for (size_t i = 0; i < count; i++) {
+            uint64_t hash = murmur64(keys[i] + h.seed);
+            uint64_t b = hash >> (64 - block_bits);
+            while (order[start[b]] != 0)
+                b = (b + 1) & (block - 1);
+            order[start[b]++] = hash;
+        }
+
+        // for every position, count its keys (upper six bits), xor their
+        // hashes and the indexes (0-2) it has among each key's positions
+        bool error = false;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t pos[3];
+            filter_positions(&h, order[i], pos);
+            for (int j = 0; j < 3; j++) {
+                t2count[pos[j]] = (t2count[pos[j]] + 4) ^ j;
+                t2hash[pos[j]] ^= order[i];
+                error |= t2count[pos[j]] < 4;
+            }
+        }
+        if (error)
+            continue;
+
+        // peel: a position holding a single key fixes that key's fingerprint;
+        // removing the key may leave its other positions with a single key
+        uint32_t queued = 0, peeled = 0;
+        for (uint32_t i = 0; i < capacity; i++) {
+            alone[queued] = i;
+            queued += (t2count[i] >> 2) == 1;
+        }
+        while (queued > 0) {
+            uint32_t index = alone[--queued];
+            if ((t2count[index] >> 2) != 1)
+                continue;
+            uint64_t hash = t2hash[index];
+            uint32_t pos[3];
+            uint8_t found = t2count[index] & 3;
+            filter_positions(&h, hash, pos);
+            order_pos[peeled] = found;
+            order[peeled++] = hash;
+            for (int j = 1; j <= 2; j++) {
+                uint32_t other = pos[(found + j) % 3];
+                alone[queued] = other;
+                queued += (t2count[other] >> 2) == 2;
+                t2count[other] = (t2count[other] - 4) ^ ((found + j) % 3);
+                t2hash[other] ^= hash;
+            }
+        }
+        if (peeled == count)
+            break;
+    }
+
+    // assign fingerprints in reverse peeling order, so each key's free
+    // position is set after the other two are final
+    for (size_t i = count; i-- > 0;) {
+        uint32_t pos[3];
+        uint8_t found = order_pos[i];
+        filter_positions(&h, order[i], pos);
+        fingerprints[pos[found]] = filter_fingerprint(&h, order[i]) ^ fingerprints[pos[(found + 1) % 3]] ^ fingerprints[pos[(found + 2) % 3]];
+    }
+
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+    if (fingerprint_bits == 8) {
+        for (uint32_t i = 0; ok && i < capacity; i++)
+            ok = putc(fingerprints[i], file) != EOF;
+    } else {
+        ok = ok && fwrite(fingerprints, sizeof(uint16_t), capacity, file) == capacity;
+    }
+
+    free(fingerprints);
+    free(order);
+    free(order_pos);
+    free(alone);
+    free(t2count);
+    free(t2hash);
+    free(start);
+    return ok;
+}
+
+// map a filter file; returns false if path is not one, with errno set if it
+// could not be read at all
+bool filter_open(struct filter *f, const char *path) {
+    struct filter_header h;
+    struct stat st;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    errno = 0;
+    if (fstat(fd, &st) != 0 || pread(fd, &h, sizeof(h), 0) != sizeof(h) || h.magic != FILTER_MAGIC ||
+        (h.fingerprint_bits != 8 && h.fingerprint_bits != 16) ||
+        (size_t)st.st_size != sizeof(h) + (size_t)h.array_length * (h.fingerprint_bits / 8)) {
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    f->header = map;
+    f->fingerprints = (const char *)map + sizeof(h);
+    f->map_size = st.st_size;
+    return true;
+}
+
+// whether key may be in the filter
+bool filter_contains(const struct filter *f, uint64_t key) {
+    const struct filter_header *h = f->header;
+    uint64_t hash = murmur64(key + h->seed);
+    uint32_t pos[3];
+    uint16_t fingerprint = filter_fingerprint(h, hash);
+    if (h->key_count == 0)
+        return false;
+    filter_positions(h, hash, pos);
+    if (h->fingerprint_bits == 8) {
+        const uint8_t *fp = f->fingerprints;
+        return fingerprint == (fp[pos[0]] ^ fp[pos[1]] ^ fp[pos[2]]);
+    }
+    const uint16_t *fp = f->fingerprints;
+    return fingerprint == (fp[pos[0]] ^ fp[pos[1]] ^ fp[pos[2]]);
+}
@@ -0,0 +1,49 @@
+#ifndef HOSTGEN_FILTER_H
+#define HOSTGEN_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// identifies a filter file built by --build-filter
+#define FILTER_MAGIC 0x31464748
+
+// binary fuse filter file header, followed by array_length fingerprints of
+// fingerprint_bits (8 or 16) bits each, in native byte order
+struct filter_header {
+    uint32_t magic;
+    uint32_t fingerprint_bits;
+    uint64_t seed;
+    uint64_t key_count;
+    uint32_t segment_length, segment_length_mask;
+    uint32_t segment_count_length, array_length;
+};
+
+// binary fuse filter (Graf and Lemire, 2022): an approximate set answering
+// membership with no false negatives and a false positive rate of
+// 2^-fingerprint_bits, in about 1.13 * fingerprint_bits bits per key. every key
+// maps to three fingerprints in neighbouring segments whose xor is its own
+// fingerprint. the fingerprints are used straight from a mapped filter file
+struct filter {
+    const struct filter_header *header;
+    const void *fingerprints;
+    size_t map_size;
+};
+
+// key of a hostname, already folded with name_fold(), for filter_contains()
+uint64_t filter_key(const char *name, size_t len);
+
+// build a filter over keys (which are sorted and deduplicated in place) with
+// fingerprints of 8 or 16 bits, starting from the given seed, and write it to
+// file; returns false on a write error
+bool filter_build(uint64_t *keys, size_t count, unsigned int fingerprint_bits, uint64_t seed, FILE *file);
+
+// map a filter file; returns false if path is not one, with errno set if it
+// could not be read at all
+bool filter_open(struct filter *f, const char *path);
+
+// whether key may be in the filter
+bool filter_contains(const struct filter *f, uint64_t key);
+
+#endif
@@ -0,0 +1,258 @@
+// per-locale first name packs for --locale, UTF-8, one name per line; each pack
+// is a single string rather than a pointer array, so it needs no relocations and
+// is only paged in when selected. names are transliterated when a pack is loaded
+// append C syntax: $ sed 's/^\(.*\)$/    "\1\\n"/g' <names-LOCALE.txt
+static const char names_de[] =
+    "Anna\n"
+    "Emma\n"
+    "Mia\n"
+    "Hannah\n"
+    "Sophie\n"
+    "Lena\n"
+    "Lea\n"
+    "Marie\n"
+    "Lina\n"
+    "Leonie\n"
+    "Johanna\n"
+    "Clara\n"
+    "Greta\n"
+    "Ida\n"
+    "Frieda\n"
+    "Charlotte\n"
+    "Mathilda\n"
+    "Luise\n"
+    "Emilia\n"
+    "Amelie\n"
+    "Jana\n"
+    "Katrin\n"
+    "Käthe\n"
+    "Bärbel\n"
+    "Gisela\n"
+    "Ursula\n"
+    "Heike\n"
+    "Sabine\n"
+    "Petra\n"
+    "Monika\n"
+    "Birgit\n"
+    "Karin\n"
+    "Renate\n"
+    "Helga\n"
+    "Jutta\n"
+    "Dörte\n"
+    "Anke\n"
+    "Silke\n"
+    "Sünje\n"
+    "Frauke\n"
+    "Jürgen\n"
+    "Jörg\n"
+    "Günter\n"
+    "Björn\n"
+    "Jens\n"
+    "Uwe\n"
+    "Dieter\n"
+    "Klaus\n"
+    "Matthias\n"
+    "Lukas\n"
+    "Leon\n"
+    "Finn\n"
+    "Jonas\n"
+    "Paul\n"
+    "Felix\n"
+    "Maximilian\n"
+    "Elias\n"
+    "Noah\n"
+    "Ben\n"
+    "Luca\n"
+    "Moritz\n"
+    "Niklas\n"
+    "Tim\n"
+    "Jan\n"
+    "Tobias\n"
+    "Sebastian\n"
+    "Florian\n"
+    "Stefan\n"
+    "Andreas\n"
+    "Thomas\n"
+    "Michael\n"
+    "Markus\n"
+    "Sören\n"
+    "Wolfgang\n"
+    "Horst\n"
+    "Manfred\n"
+    "Heinz\n"
+    "Rüdiger\n"
+    "Jörn\n"
+    "Götz\n"
+    "Malte\n"
+    "Hauke\n"
+    "Henning\n"
+    "Ole\n"
+    "Till\n"
+    "Joachim\n";
+
+static const char names_es[] =
+    "Sofía\n"
+    "Lucía\n"
+    "María\n"
+    "Martina\n"
+    "Paula\n"
+    "Julia\n"
+    "Valeria\n"
+    "Daniela\n"
+    "Alba\n"
+    "Carmen\n"
+    "Elena\n"
+    "Noa\n"
+    "Irene\n"
+    "Nerea\n"
+    "Ainhoa\n"
+    "Inés\n"
+    "Begoña\n"
+    "Rocío\n"
+    "Pilar\n"
+    "Marta\n"
+    "Laura\n"
+    "Cristina\n"
+    "Mónica\n"
+    "Verónica\n"
+    "Lourdes\n"
+    "Montserrat\n"
+    "Ximena\n"
+    "Guadalupe\n"
+    "Beatriz\n"
+    "Nuria\n"
+    "Ana\n"
+    "Eva\n"
+    "Rosa\n"
+    "Ángela\n"
+    "Aitana\n"
+    "Candela\n"
+    "Alejandro\n"
+    "Hugo\n"
+    "Pablo\n"
+    "Álvaro\n"
+    "Adrián\n"
+    "Diego\n"
+    "Mario\n"
+    "Javier\n"
+    "Sergio\n"
+    "Manuel\n"
+    "José\n"
+    "Juan\n"
+    "Antonio\n"
+    "Francisco\n"
+    "Jesús\n"
+    "Ángel\n"
+    "Rubén\n"
+    "Iñaki\n"
+    "Íñigo\n"
+    "Joaquín\n"
+    "Martín\n"
+    "Nicolás\n"
+    "Andrés\n"
+    "Raúl\n"
+    "Óscar\n"
+    "Gonzalo\n"
+    "Ramón\n"
+    "Fernando\n"
+    "Carlos\n"
+    "Luis\n"
+    "Miguel\n"
+    "Rafael\n"
+    "Sebastián\n"
+    "Tomás\n"
+    "Ignacio\n"
+    "Jaime\n"
+    "Héctor\n"
+    "Víctor\n"
+    "Lucas\n"
+    "Mateo\n"
+    "Marcos\n"
+    "Jorge\n"
+    "Enrique\n";
+
+static const char names_tr[] =
+    "Zeynep\n"
+    "Elif\n"
+    "Defne\n"
+    "Eylül\n"
+    "Azra\n"
+    "Ecrin\n"
+    "Nehir\n"
+    "Asya\n"
+    "Yağmur\n"
+    "Büşra\n"
+    "Merve\n"
+    "Gül\n"
+    "Şeyma\n"
+    "Özge\n"
+    "Çağla\n"
+    "Gökçe\n"
+    "Sıla\n"
+    "Ayşe\n"
+    "Fatma\n"
+    "Emine\n"
+    "Hatice\n"
+    "Esra\n"
+    "İrem\n"
+    "Damla\n"
+    "Derya\n"
+    "Ebru\n"
+    "Selin\n"
+    "Kübra\n"
+    "Tuğçe\n"
+    "Nazlı\n"
+    "Yusuf\n"
+    "Eymen\n"
+    "Ömer\n"
+    "Mustafa\n"
+    "Mehmet\n"
+    "Ahmet\n"
+    "Ali\n"
+    "Hasan\n"
+    "Hüseyin\n"
+    "İbrahim\n"
+    "İsmail\n"
+    "Murat\n"
+    "Emre\n"
+    "Burak\n"
+    "Can\n"
+    "Cem\n"
+    "Kerem\n"
+    "Barış\n"
+    "Oğuz\n"
+    "Çağrı\n"
+    "Doğan\n"
+    "Gökhan\n"
+    "Serkan\n"
+    "Volkan\n"
+    "Tolga\n"
+    "Onur\n"
+    "Uğur\n"
+    "Özgür\n"
+    "Şahin\n"
+    "Kaan\n"
+    "Berk\n"
+    "Arda\n"
+    "Efe\n"
+    "Alp\n"
+    "Deniz\n"
+    "Eren\n"
+    "Furkan\n"
+    "Enes\n"
+    "Halil\n"
+    "Şükrü\n"
+    "Rıza\n"
+    "Fırat\n"
+    "Işık\n"
+    "Erdoğan\n"
+    "Tarık\n";
+
+static const struct {
+    const char *locale;
+    const char *names;
+} name_packs[] = {
+    {"de", names_de},
+    {"es", names_es},
+    {"tr", names_tr},
+};
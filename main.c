@@ -1,27 +1,278 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
-// long list of names in names.h
+#include "platforms.h"
+#include "chacha.h"
+#include "probes.h"
+#include "nameset.h"
+#include "editindex.h"
+#include "sorter.h"
+#include "arena.h"
+#include "filter.h"
+#include "suffix.h"
+#include "ouis.h"
+
+// long list of names in names.h, per-locale packs in locales.h
+#ifdef WITH_NAMES
 #include "names.h"
+#include "locales.h"
+#endif
 
 // preproc macros for version info for now, no build system yet
 #define HOSTGEN_VERSION "v0.3a"
 
+// number of entries in first_names[]
+#define NAME_COUNT (sizeof(first_names) / sizeof(first_names[0]))
+
+// names are picked from name_list, which is first_names[] unless --names is given
+#ifdef WITH_NAMES
+const char *const *name_list = first_names;
+unsigned int name_count = NAME_COUNT;
+#endif
+
+// longest hostname any generator can produce, including the newline
+#define HOSTNAME_MAX 64
+
+// longest hostname label allowed by RFC 1123
+#define LABEL_MAX 63
+
+// longest record any output format can produce for one hostname
+#define RECORD_MAX 256
+
+// bits of an index record holding the rank; the platform id takes the rest.
+// platforms with larger keyspaces are refused by platform_fits_index()
+#define RANK_MASK ((UINT64_C(1) << 56) - 1)
+
+// size of the output buffer hostnames are assembled in
+#define SINK_SIZE 65536
+
+// counts above this are generated and written on separate threads
+#define PIPELINE_THRESHOLD 4096
+
+// system-wide config file; the per-user one is $XDG_CONFIG_HOME/hostgen
+#define SYSTEM_CONFIG "/etc/hostgen.conf"
+
+// identifies a config snapshot written by this build
+#define SNAPSHOT_MAGIC 0x48475331
+#define SNAPSHOT_VERSION 3
+
+// memory --sort uses before spilling sorted runs to temporary files, unless
+// --mem-limit says otherwise
+#define SORT_MEM_LIMIT (256UL << 20)
+
+// bytes of stdin read at once in batch mode; also the longest job spec line
+#define BATCH_BUF_SIZE 65536
+
+// chance that a --check-dist run of a sound generator fails anyway; it is split
+// evenly between the tests (Bonferroni), however many platforms are built in
+#define CHECK_DIST_ALPHA 1e-3
+
+// bytes of kernel entropy fetched at once; enough to seed three threads
+#define ENTROPY_POOL_SIZE 256
+
 // char arrays
 char *option_platform = "";
+char *option_output = NULL;
+char *option_stats_arg = NULL;
+char *option_bench_arg = NULL;
+char *option_check_dist_arg = NULL;
+char *option_metrics_arg = NULL;
+char *option_exclude = NULL;
+char *option_build_filter = NULL;
+char option_prefix[LABEL_MAX + 1] = "";
+char option_suffix[LABEL_MAX + 1] = "";
+size_t option_prefix_len = 0, option_suffix_len = 0;
+
+// numeric options
+unsigned long option_count = 1;
+double option_rate = 0;
+unsigned int option_min_distance = 0;
+size_t option_mem_limit = SORT_MEM_LIMIT;
+unsigned int option_fingerprint_bits = 8;
+
+// bool options
+bool option_append = false;
+bool option_batch_stdin = false;
+bool option_crypto = false;
+bool option_metadata = false;
+bool option_with_mac = false;
+bool option_stats = false;
+bool option_bench = false;
+bool option_check_dist = false;
+bool option_metrics = false;
+bool option_unique = false;
+bool option_sort = false;
+
+// long-only option codes
+enum ELongOption { OPT_BATCH_STDIN = 256, OPT_STATS, OPT_BENCH, OPT_CRYPTO, OPT_METADATA, OPT_METRICS, OPT_EXCLUDE, OPT_MIN_DISTANCE, OPT_UNIQUE, OPT_SORT, OPT_MEM_LIMIT, OPT_NO_CONFIG, OPT_STREAM, OPT_BUILD_FILTER, OPT_FP_RATE, OPT_WITH_MAC, OPT_CHECK_DIST };
+
+// byte classes for hostname normalization: letters, digits and hyphens are kept,
+// separators become hyphens, UTF-8 lead bytes of U+00C0..U+017F are
+// transliterated to ASCII, everything else is dropped
+enum ECharClass { CH_DROP, CH_KEEP, CH_HYPHEN, CH_LATIN };
+static const unsigned char char_class[256] = {
+    ['0' ... '9'] = CH_KEEP, ['A' ... 'Z'] = CH_KEEP, ['a' ... 'z'] = CH_KEEP, ['-'] = CH_KEEP,
+    [' '] = CH_HYPHEN, ['_'] = CH_HYPHEN, ['.'] = CH_HYPHEN, ['/'] = CH_HYPHEN, [':'] = CH_HYPHEN,
+    ['\t'] = CH_HYPHEN, [0xc3 ... 0xc5] = CH_LATIN,
+};
+
+// ASCII transliteration of U+00C0..U+017F (Latin-1 Supplement and Latin
+// Extended-A), indexed by code point - 0xc0; umlauts follow the German
+// convention, empty strings drop the character
+static const char latin_translit[192][3] = {
+    "A", "A", "A", "A", "Ae", "A", "Ae", "C",
+    "E", "E", "E", "E", "I", "I", "I", "I",
+    "D", "N", "O", "O", "O", "O", "Oe", "",
+    "O", "U", "U", "U", "Ue", "Y", "Th", "ss",
+    "a", "a", "a", "a", "ae", "a", "ae", "c",
+    "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "oe", "",
+    "o", "u", "u", "u", "ue", "y", "th", "y",
+    "A", "a", "A", "a", "A", "a", "C", "c",
+    "C", "c", "C", "c", "C", "c", "D", "d",
+    "D", "d", "E", "e", "E", "e", "E", "e",
+    "E", "e", "E", "e", "G", "g", "G", "g",
+    "G", "g", "G", "g", "H", "h", "H", "h",
+    "I", "i", "I", "i", "I", "i", "I", "i",
+    "I", "i", "IJ", "ij", "J", "j", "K", "k",
+    "k", "L", "l", "L", "l", "L", "l", "L",
+    "l", "L", "l", "N", "n", "N", "n", "N",
+    "n", "n", "N", "n", "O", "o", "O", "o",
+    "O", "o", "Oe", "oe", "R", "r", "R", "r",
+    "R", "r", "S", "s", "S", "s", "S", "s",
+    "S", "s", "T", "t", "T", "t", "T", "t",
+    "U", "u", "U", "u", "U", "u", "U", "u",
+    "U", "u", "U", "u", "W", "w", "Y", "y",
+    "Y", "Z", "z", "Z", "z", "Z", "z", "s",
+};
 
-// platform type enum
-enum EPlatformType { ANY, WINDOWS, MACBOOK, MACMINI };
+// platform names, indexed by EPlatformType
+static const char *platform_names[] = {"any", "windows", "macbook", "macmini", "mac", "imac", "macstudio", "iphone", "ipad", "android", "chromebook", "linux", "winserver"};
+
+// output format enum
+enum EOutputFormat { TEXT, BINARY, INDEX, NDJSON, CSV };
+static const char *format_names[] = {"text", "binary", "index", "ndjson", "csv"};
+enum EOutputFormat option_format = TEXT;
+
+// buffered output; hostnames are assembled directly in buf and written in large chunks
+struct output_sink {
+    int fd;
+    size_t len;
+    unsigned long long total;
+    char buf[SINK_SIZE];
+};
+
+// identity of a file a config snapshot was built from; all zero if it did not exist
+struct file_stamp {
+    int64_t mtime_sec, mtime_nsec, size, inode;
+};
+
+// config snapshot file header; followed by option_count snapshot_options,
+// name_count uint32 string offsets of names and the string area, which ends
+// in a NUL
+struct snapshot_header {
+    uint32_t magic, version;
+    char hostgen_version[16];
+    uint64_t build_id;
+    struct file_stamp system_config, user_config, names_file;
+    uint32_t option_count, name_count, strings_size;
+};
+
+// one option from a config file: string offsets of its long option name, which
+// unlike the getopt code stays the same across versions, and of its argument,
+// or UINT32_MAX for none
+struct snapshot_option {
+    uint32_t name, arg;
+};
+
+// double-buffered generator/writer handoff; the generator fills one sink
+// while the writer flushes the other
+struct pipeline {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct output_sink *sinks[2];
+    bool full[2];
+    bool done;
+    enum EPlatformType platform_type;
+    unsigned long count;
+};
+
+// phases of a run that --metrics reports the time spent in
+enum EMetricPhase { PHASE_SETUP, PHASE_GENERATE, PHASE_SORT, PHASE_WRITE, PHASE_WAIT, PHASE_COUNT };
+static const char *phase_names[] = {"setup", "generate", "sort", "write", "wait"};
+
+// hot-path counters; every thread bumps its own copy, which is merged into
+// metrics_total under metrics_lock
+struct metrics {
+    uint64_t hostnames[sizeof(platform_names) / sizeof(platform_names[0])];
+    uint64_t rng_draws, rng_rejections, duplicate_rejections;
+    uint64_t bytes_written, write_calls, sort_runs;
+    uint64_t phase_ns[PHASE_COUNT];
+};
+
+// counters compile to nothing unless built with METRICS=yes
+#ifdef WITH_METRICS
+static __thread struct metrics thread_metrics;
+static struct metrics metrics_total;
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+#define METRIC_ADD(field, n) (thread_metrics.field += (n))
+#define METRIC_START(var) uint64_t var = get_time_ns()
+#define METRIC_END(phase, var) (thread_metrics.phase_ns[phase] += get_time_ns() - (var))
+#else
+#define METRIC_ADD(field, n) ((void)0)
+#define METRIC_START(var) ((void)0)
+#define METRIC_END(phase, var) ((void)0)
+#endif
 
 // command line options
+#define SHORT_OPTIONS "ac:f:hl:n:o:p:P:r:s:v"
 static struct option long_options[] = {
+    {"append", no_argument, 0, 'a'},
+    {"batch-stdin", no_argument, 0, OPT_BATCH_STDIN},
+    {"bench", optional_argument, 0, OPT_BENCH},
+    {"build-filter", required_argument, 0, OPT_BUILD_FILTER},
+    {"check-dist", optional_argument, 0, OPT_CHECK_DIST},
+    {"count", required_argument, 0, 'c'},
+    {"crypto", no_argument, 0, OPT_CRYPTO},
+    {"exclude", required_argument, 0, OPT_EXCLUDE},
+    {"format", required_argument, 0, 'f'},
+    {"fp-rate", required_argument, 0, OPT_FP_RATE},
     {"help", no_argument, 0, 'h'},
+    {"locale", required_argument, 0, 'l'},
+    {"mem-limit", required_argument, 0, OPT_MEM_LIMIT},
+    {"metadata", no_argument, 0, OPT_METADATA},
+    {"metrics", optional_argument, 0, OPT_METRICS},
+    {"min-distance", required_argument, 0, OPT_MIN_DISTANCE},
+    {"names", required_argument, 0, 'n'},
+    {"no-config", no_argument, 0, OPT_NO_CONFIG},
+    {"output", required_argument, 0, 'o'},
     {"platform", required_argument, 0, 'p'},
+    {"prefix", required_argument, 0, 'P'},
+    {"rate", required_argument, 0, 'r'},
+    {"sort", no_argument, 0, OPT_SORT},
+    {"stats", optional_argument, 0, OPT_STATS},
+    {"suffix", required_argument, 0, 's'},
+    {"stream", no_argument, 0, OPT_STREAM},
+    {"unique", no_argument, 0, OPT_UNIQUE},
     {"version", no_argument, 0, 'v'},
+    {"with-mac", no_argument, 0, OPT_WITH_MAC},
     {0, 0, 0, 0}
 };
 
@@ -31,76 +282,2179 @@ void display_help_message(char *program_name) {
            "Generate randomized system hostnames mimicking various platforms.\n"
            "\n"
            "Options:\n"
+           "  -a, --append              append to FILE instead of truncating it\n"
+           "      --batch-stdin         read job specs ('PLATFORM COUNT [prefix=P] [suffix=S]')\n"
+           "                            from stdin, one per line, and answer them in order\n"
+           "      --bench[=COUNT]       benchmark every platform and output path, print JSON\n"
+           "      --build-filter=FILE   write a filter of the hostnames on stdin, one per line,\n"
+           "                            to FILE for use with --exclude, then exit\n"
+           "      --check-dist[=DRAWS]  chi-square test name, suffix and platform mix\n"
+           "                            distributions over DRAWS per platform, then exit\n"
+           "  -c, --count=COUNT         generate COUNT hostnames instead of one, 0 for endless\n"
+           "      --crypto              draw all randomness from a ChaCha20 keystream\n"
+           "      --exclude=FILE        never generate a hostname listed in FILE, or in the filter\n"
+           "                            FILE; implies --unique\n"
+           "  -f, --format=FORMAT       write hostnames as FORMAT (see below)\n"
+           "      --fp-rate=RATE        highest false positive rate of --build-filter; 1/256\n"
+           "                            (default) or above takes 9 bits per name, down to\n"
+           "                            1/65536 takes 18\n"
            "  -h, --help                display this message\n"
+           "  -l, --locale=LOCALE       pick first names from the LOCALE pack: en, de, es, tr\n"
+           "      --metrics[=FORMAT]    print counters to stderr on exit as 'prometheus' text\n"
+           "                            (default) or 'json'\n"
+           "      --mem-limit=SIZE      memory --sort may use before spilling to temporary\n"
+           "                            files (suffixes K, M, G; default 256M)\n"
+           "      --metadata            add platform and rank columns to csv/ndjson output\n"
+           "      --min-distance=K      keep every hostname more than K (1-3) edits away from all\n"
+           "                            earlier and excluded ones; implies --unique\n"
+           "  -n, --names=NAMEFILE      pick first names from NAMEFILE (UTF-8, one per line)\n"
+           "      --no-config           ignore /etc/hostgen.conf and ~/.config/hostgen\n"
+           "  -o, --output=FILE         write hostnames to FILE instead of stdout\n"
            "  -p, --platform=PLATFORM   make the hostname emulate the default for PLATFORM\n"
+           "  -P, --prefix=PREFIX       prepend PREFIX to every hostname\n"
+           "  -r, --rate=RATE           emit at most RATE hostnames per second, evenly paced\n"
+           "  -s, --suffix=SUFFIX       append SUFFIX to every hostname\n"
+           "      --sort                output hostnames in byte order, without repeats\n"
+           "      --stats[=DRAWS]       print keyspace sizes and expected collisions, then exit\n"
+           "      --stream              generate hostnames until the reader goes away\n"
+           "      --unique              never repeat a hostname (compared ignoring case)\n"
            "  -v, --version             display version information\n"
+           "      --with-mac            add a MAC address from a vendor matching the platform to\n"
+           "                            text, csv and ndjson output\n"
            "\n"
            "Platforms:\n"
-           "  mac           Alias to either macbook or macmini, random at runtime\n"
+           "  android       android-[XXXXXXXXXXXXXXXX]; 'X' are random, lowercase hex digits\n"
+           "  chromebook    chromeos-[XXXXXXXXXXXX]; 'X' are random, lowercase hex digits\n"
+           "  imac          [Name]s-iMac; 'Name' is random\n"
+           "  ipad          [Name]s-iPad; 'Name' is random\n"
+           "  iphone        [Name]s-iPhone; 'Name' is random\n"
+           "  linux         [name]-[Model]; 'name' is random, 'Model' is a laptop or desktop\n"
+           "                model such as ThinkPad-X1; aliases ubuntu, fedora\n"
+           "  mac           Alias to one of macbook, macmini, imac or macstudio, random at\n"
+           "                runtime\n"
            "  macbook       [Name]s-Macbook-[Prod]; 'Name' is random, 'Prod' is Air or Pro\n"
            "  macmini       [Name]s-Mac-Mini; 'Name' is random\n"
+           "  macstudio     [Name]s-Mac-Studio; 'Name' is random\n"
            "  windows       DESKTOP-[XXXXXXX]; 'X' are random, capital alphanumeric chars\n"
+           "  winserver     WIN-[XXXXXXXXXXX]; 'X' are random, capital alphanumeric chars\n"
+           "\n"
+           "Formats:\n"
+           "  text          one hostname per line (default)\n"
+           "  binary        64-byte records: length byte, hostname, zero padding\n"
+           "  index         8-byte little-endian records: platform id << 56 | rank;\n"
+           "                not for android or winserver, or any with either built in\n"
+           "  ndjson        one JSON object per line\n"
+           "  csv           comma-separated values with a header line\n"
            , program_name);
     exit(0);
 }
 
-// generate a random ASCII number/uppercase character
-char get_random_char(bool is_ucase) {
-    unsigned int rnum = rand() % 36;
-    if (rnum < 10)
-        return '0' + rnum;
-    return (is_ucase == true ? ('A' + (rnum - 10)) : ('a' + (rnum - 10)));
+// kernel entropy, fetched one block at a time and handed out to rng_seed()
+static unsigned char entropy_pool[ENTROPY_POOL_SIZE];
+static size_t entropy_used = ENTROPY_POOL_SIZE;
+static pthread_mutex_t entropy_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// per-thread xoshiro256** state
+static __thread uint64_t rng_state[4];
+
+// per-thread ChaCha20 keystream used instead with --crypto
+static __thread struct chacha_rng crypto_rng;
+
+// refill the entropy pool from getrandom(2), or /dev/urandom on kernels without it
+void refill_entropy_pool(void) {
+    size_t got = 0;
+    while (got < ENTROPY_POOL_SIZE) {
+        ssize_t ret = getrandom(entropy_pool + got, ENTROPY_POOL_SIZE - got, 0);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0) break;
+        got += ret;
+    }
+    if (got < ENTROPY_POOL_SIZE) {
+        int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+        if (fd < 0 || read(fd, entropy_pool, ENTROPY_POOL_SIZE) != ENTROPY_POOL_SIZE) {
+            fprintf(stderr, "hostgen: cannot read random seed\n");
+            exit(1);
+        }
+        close(fd);
+    }
+    entropy_used = 0;
+}
+
+// copy len bytes of entropy into buf
+void get_entropy(void *buf, size_t len) {
+    pthread_mutex_lock(&entropy_lock);
+    if (entropy_used + len > ENTROPY_POOL_SIZE)
+        refill_entropy_pool();
+    memcpy(buf, entropy_pool + entropy_used, len);
+    entropy_used += len;
+    pthread_mutex_unlock(&entropy_lock);
 }
 
-// pick a random name from the first_names[] array
-const char *get_random_name(void) {
-    unsigned int name_ct = sizeof(first_names) / sizeof(first_names[0]);
-    unsigned int name_index = rand() % (name_ct - 1);
-    return first_names[name_index];
+// seed the calling thread's rngs; must run once in every thread that generates
+void rng_seed(void) {
+    uint8_t crypto_seed[40];
+    get_entropy(crypto_seed, sizeof(crypto_seed));
+    chacha_rng_init(&crypto_rng, crypto_seed);
+    get_entropy(rng_state, sizeof(rng_state));
+    // xoshiro gets stuck on an all-zero state
+    if ((rng_state[0] | rng_state[1] | rng_state[2] | rng_state[3]) == 0)
+        rng_state[0] = 1;
 }
 
-// set platform_type enum
-enum EPlatformType set_platform_type(char *type_name) {
+// next 64-bit output of the calling thread's xoshiro256** generator, or of
+// its ChaCha20 keystream with --crypto
+static inline uint64_t rng_next(void) {
+    METRIC_ADD(rng_draws, 1);
+    if (option_crypto)
+        return chacha_rng_next(&crypto_rng);
+    uint64_t *s = rng_state;
+    uint64_t result = s[1] * 5;
+    result = (result << 7 | result >> 57) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = s[3] << 45 | s[3] >> 19;
+    return result;
+}
+
+// uniform random number in [0, bound); multiply-shift with rejection of the
+// few low products that would otherwise make some values more likely
+unsigned int rand_below(unsigned int bound) {
+    uint64_t m = (rng_next() >> 32) * bound;
+    if ((uint32_t)m < bound) {
+        uint32_t threshold = -bound % bound;
+        while ((uint32_t)m < threshold) {
+            METRIC_ADD(rng_rejections, 1);
+            m = (rng_next() >> 32) * bound;
+        }
+    }
+    return m >> 32;
+}
+
+// write count (at most BASE36_MAX_DIGITS) random base-36 digits to out, with
+// letters from letter, from a single draw unless it has to be rejected; returns
+// the number they spell, which is the hostname's rank
+static inline uint64_t rand_base36(char *out, int count, char letter) {
+    uint64_t bound = base36_pow[count], r = rng_next();
+    unsigned __int128 m = (unsigned __int128)r * bound;
+    if ((uint64_t)m < bound) {
+        uint64_t threshold = -bound % bound;
+        while ((uint64_t)m < threshold) {
+            METRIC_ADD(rng_rejections, 1);
+            r = rng_next();
+            m = (unsigned __int128)r * bound;
+        }
+    }
+    base36_digits(r, count, out, letter);
+    return m >> 64;
+}
+
+// nanoseconds on the monotonic clock
+uint64_t get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#ifdef WITH_METRICS
+// add the calling thread's counters to the totals and reset them
+void metrics_merge(void) {
+    uint64_t *from = (uint64_t *)&thread_metrics, *to = (uint64_t *)&metrics_total;
+    pthread_mutex_lock(&metrics_lock);
+    for (size_t i = 0; i < sizeof(struct metrics) / sizeof(uint64_t); i++)
+        to[i] += from[i];
+    pthread_mutex_unlock(&metrics_lock);
+    memset(&thread_metrics, 0, sizeof(thread_metrics));
+}
+
+// print the merged counters to stderr; run at exit with --metrics
+void display_metrics(void) {
+    struct metrics *m = &metrics_total;
+    bool json = option_metrics_arg != NULL && strcmp(option_metrics_arg, "json") == 0;
+    metrics_merge();
+    pthread_mutex_lock(&metrics_lock);
+
+    if (json) {
+        fprintf(stderr, "{\"hostnames\":{");
+        for (int t = 0, first = 1; t < (int)(sizeof(m->hostnames) / sizeof(m->hostnames[0])); t++)
+            if (t != ANY && t != MAC && platform_enabled(t)) {
+                fprintf(stderr, "%s\"%s\":%llu", first ? "" : ",", platform_names[t], (unsigned long long)m->hostnames[t]);
+                first = 0;
+            }
+        fprintf(stderr, "},\"rng_draws\":%llu,\"rng_rejections\":%llu,\"duplicate_rejections\":%llu,\"bytes_written\":%llu,\"write_calls\":%llu,\"sort_runs\":%llu,\"phase_seconds\":{",
+                (unsigned long long)m->rng_draws, (unsigned long long)m->rng_rejections, (unsigned long long)m->duplicate_rejections,
+                (unsigned long long)m->bytes_written, (unsigned long long)m->write_calls, (unsigned long long)m->sort_runs);
+        for (int p = 0; p < PHASE_COUNT; p++)
+            fprintf(stderr, "%s\"%s\":%.9f", p == 0 ? "" : ",", phase_names[p], m->phase_ns[p] / 1e9);
+        fprintf(stderr, "}}\n");
+    } else {
+        fprintf(stderr, "# HELP hostgen_hostnames_total Hostnames generated, by platform.\n"
+                        "# TYPE hostgen_hostnames_total counter\n");
+        for (int t = 0; t < (int)(sizeof(m->hostnames) / sizeof(m->hostnames[0])); t++)
+            if (t != ANY && t != MAC && platform_enabled(t))
+                fprintf(stderr, "hostgen_hostnames_total{platform=\"%s\"} %llu\n", platform_names[t], (unsigned long long)m->hostnames[t]);
+        fprintf(stderr, "# HELP hostgen_rng_draws_total 64-bit random numbers drawn.\n"
+                        "# TYPE hostgen_rng_draws_total counter\n"
+                        "hostgen_rng_draws_total %llu\n"
+                        "# HELP hostgen_rng_rejections_total Draws rejected to keep bounded random numbers uniform.\n"
+                        "# TYPE hostgen_rng_rejections_total counter\n"
+                        "hostgen_rng_rejections_total %llu\n"
+                        "# HELP hostgen_duplicate_rejections_total Candidates redrawn for --unique, --exclude or --min-distance.\n"
+                        "# TYPE hostgen_duplicate_rejections_total counter\n"
+                        "hostgen_duplicate_rejections_total %llu\n"
+                        "# HELP hostgen_bytes_written_total Bytes of output written.\n"
+                        "# TYPE hostgen_bytes_written_total counter\n"
+                        "hostgen_bytes_written_total %llu\n"
+                        "# HELP hostgen_write_calls_total write() system calls made for output.\n"
+                        "# TYPE hostgen_write_calls_total counter\n"
+                        "hostgen_write_calls_total %llu\n"
+                        "# HELP hostgen_sort_runs_total Sorted runs spilled to temporary files by --sort.\n"
+                        "# TYPE hostgen_sort_runs_total counter\n"
+                        "hostgen_sort_runs_total %llu\n"
+                        "# HELP hostgen_phase_seconds_total Time spent in each phase, summed over threads.\n"
+                        "# TYPE hostgen_phase_seconds_total counter\n",
+                (unsigned long long)m->rng_draws, (unsigned long long)m->rng_rejections, (unsigned long long)m->duplicate_rejections,
+                (unsigned long long)m->bytes_written, (unsigned long long)m->write_calls, (unsigned long long)m->sort_runs);
+        for (int p = 0; p < PHASE_COUNT; p++)
+            fprintf(stderr, "hostgen_phase_seconds_total{phase=\"%s\"} %.9f\n", phase_names[p], m->phase_ns[p] / 1e9);
+    }
+    pthread_mutex_unlock(&metrics_lock);
+}
+#endif
+
+#ifdef WITH_NAMES
+// pick a random name from name_list, store its index in name_index
+const char *get_random_name(unsigned int *name_index) {
+    *name_index = rand_below(name_count);
+    return name_list[*name_index];
+}
+#endif
+
+// normalize in, up to its end or first newline, to a valid hostname fragment of
+// at most max bytes in out, return its length; leading hyphens are dropped when
+// the fragment starts a hostname
+size_t normalize_hostname(const char *in, char *out, size_t max, bool is_start) {
+    const unsigned char *s = (const unsigned char *)in;
+    size_t len = 0;
+    for (; *s != '\0' && *s != '\n' && len < max; s++) {
+        const char *translit;
+        switch (char_class[*s]) {
+            case CH_KEEP:
+                out[len++] = *s;
+                break;
+            case CH_HYPHEN:
+                if (!is_start || len > 0)
+                    out[len++] = '-';
+                break;
+            case CH_LATIN:
+                if (s[1] < 0x80 || s[1] >= 0xc0)
+                    break;
+                translit = latin_translit[((s[0] & 0x1f) << 6 | (s[1] & 0x3f)) - 0xc0];
+                s++;
+                for (; *translit != '\0' && len < max; translit++)
+                    out[len++] = *translit;
+                break;
+            default: break;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// set a --prefix/--suffix option, telling the user if it had to be changed
+size_t set_affix(const char *arg, char *out, bool is_start, const char *what) {
+    size_t len = normalize_hostname(arg, out, LABEL_MAX, is_start);
+    if (strcmp(arg, out) != 0)
+        fprintf(stderr, "hostgen: %s '%s' normalized to '%s'\n", what, arg, out);
+    return len;
+}
+
+// read a whole file into a NUL-terminated buffer, NULL with errno set if it
+// cannot be read; reads to the end, so pipes and process substitutions work too
+char *read_file(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    char *text = NULL;
+    size_t len = 0, capacity = 0;
+    if (file == NULL)
+        return NULL;
+    while (true) {
+        if (len == capacity) {
+            capacity = capacity ? capacity * 2 : 65536;
+            char *grown = realloc(text, capacity + 1);
+            if (grown == NULL)
+                break;
+            text = grown;
+        }
+        len += fread(text + len, 1, capacity - len, file);
+        if (len < capacity)
+            break;
+    }
+    if (len < capacity && !ferror(file)) {
+        text[len] = '\0';
+        *size = len;
+    } else {
+        int saved = errno;
+        free(text);
+        text = NULL;
+        errno = saved;
+    }
+    fclose(file);
+    return text;
+}
+
+#ifdef WITH_NAMES
+// loaded name list; its names are packed into the arena, which is reused when
+// another list replaces it
+static struct arena name_arena;
+static const char **loaded_names;
+
+// build name_list from UTF-8 text with one name per line; every name is
+// transliterated and normalized once here into a packed ASCII pool, so picking
+// a loaded name costs the same as picking a built-in one. names that normalize
+// to one already listed (ignoring case, as hostnames do) are dropped, so every
+// name stays equally likely. returns false if no usable name was found
+bool load_name_text(const char *text, size_t size) {
+    const char **list = NULL;
+    unsigned int count = 0, capacity = 0;
+    struct name_set seen = {0};
+    char folded[LABEL_MAX + 1];
+
+    // normalized names are never longer than their source lines, so one block
+    // holds all of the text with each newline turned into a terminator, and
+    // the names never move once listed
+    if (name_list == loaded_names)
+        name_list = first_names, name_count = NAME_COUNT;
+    free(loaded_names);
+    loaded_names = NULL;
+    arena_reset(&name_arena);
+    char *pool_end = arena_at(&name_arena, arena_alloc(&name_arena, size + 1));
+    for (const char *line = text, *next; line < text + size; line = next) {
+        next = memchr(line, '\n', text + size - line);
+        next = next != NULL ? next + 1 : text + size;
+        if (line[0] == '#')
+            continue;
+        size_t len = normalize_hostname(line, pool_end, LABEL_MAX, true);
+        while (len > 0 && pool_end[len - 1] == '-')
+            pool_end[--len] = '\0';
+        if (len == 0)
+            continue;
+        name_fold(pool_end, len, folded);
+        if (name_set_add(&seen, folded, len) == UINT32_MAX)
+            continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            list = realloc(list, capacity * sizeof(list[0]));
+        }
+        list[count++] = pool_end;
+        pool_end += len + 1;
+    }
+    arena_free(&seen.pool);
+    free(seen.slots);
+
+    if (count == 0) {
+        free(list);
+        return false;
+    }
+    name_list = loaded_names = list;
+    name_count = count;
+    return true;
+}
+
+// load a name list file into name_list
+void load_names(const char *path) {
+    size_t size;
+    char *text = read_file(path, &size);
+    if (text == NULL) {
+        fprintf(stderr, "hostgen: %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+
+    if (!load_name_text(text, size)) {
+        fprintf(stderr, "hostgen: %s: no usable names\n", path);
+        exit(1);
+    }
+    free(text);
+}
+
+// switch name_list to an embedded locale pack; only the chosen pack is read,
+// so the pages of the others are never touched
+void set_locale(const char *locale) {
+    if (strcmp(locale, "en") == 0) {
+        name_list = first_names;
+        name_count = NAME_COUNT;
+        return;
+    }
+    for (unsigned int i = 0; i < sizeof(name_packs) / sizeof(name_packs[0]); i++) {
+        if (strcmp(locale, name_packs[i].locale) == 0) {
+            load_name_text(name_packs[i].names, strlen(name_packs[i].names));
+            return;
+        }
+    }
+    fprintf(stderr, "hostgen: unknown locale: '%s'; available: en", locale);
+    for (unsigned int i = 0; i < sizeof(name_packs) / sizeof(name_packs[0]); i++)
+        fprintf(stderr, ", %s", name_packs[i].locale);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+#endif
+
+// map a platform name to its enum; anything unrecognized means any platform
+enum EPlatformType parse_platform_type(const char *type_name) {
     if (strncmp(type_name, "macmini", 5) == 0)
         return MACMINI;
-    if (strncmp(type_name, "macbook", 5) == 0)
+    else if (strncmp(type_name, "macbook", 5) == 0)
         return MACBOOK;
-    if (strncmp(type_name, "mac", 3) == 0)
-        return (rand() % 2) == 0 ? MACBOOK : MACMINI;
-    if (strncmp(type_name, "windows", 3) == 0)
+    else if (strncmp(type_name, "macstudio", 5) == 0)
+        return MACSTUDIO;
+    else if (strncmp(type_name, "mac", 3) == 0)
+        return MAC;
+    else if (strncmp(type_name, "imac", 4) == 0)
+        return IMAC;
+    else if (strncmp(type_name, "iphone", 3) == 0)
+        return IPHONE;
+    else if (strncmp(type_name, "ipad", 3) == 0)
+        return IPAD;
+    else if (strncmp(type_name, "android", 4) == 0)
+        return ANDROID;
+    else if (strncmp(type_name, "chromebook", 6) == 0)
+        return CHROMEBOOK;
+    else if (strncmp(type_name, "linux", 5) == 0 || strncmp(type_name, "ubuntu", 6) == 0 || strncmp(type_name, "fedora", 6) == 0)
+        return LINUX;
+    else if (strncmp(type_name, "winserver", 5) == 0 || strncmp(type_name, "winsrv", 5) == 0)
+        return WINSERVER;
+    else if (strncmp(type_name, "windows", 3) == 0)
         return WINDOWS;
-    int platform_rng = rand() % 16;
-    if (platform_rng <= 3) return MACBOOK;
-    if (platform_rng <= 4) return MACMINI;
-    if (platform_rng >= 5) return WINDOWS;
     return ANY;
 }
 
+// set platform_type enum
+enum EPlatformType set_platform_type(char *type_name) {
+    enum EPlatformType platform_type = parse_platform_type(type_name);
+    if (!platform_enabled(platform_type)) {
+        fprintf(stderr, "hostgen: platform not compiled in: '%s'\n", type_name);
+        exit(1);
+    }
+    return platform_type;
+}
+
+// set output format enum
+enum EOutputFormat set_output_format(char *format_name) {
+    for (unsigned int i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++)
+        if (strcmp(format_name, format_names[i]) == 0)
+            return i;
+    fprintf(stderr, "hostgen: unknown output format: '%s'\n", format_name);
+    exit(1);
+}
+
+// ANY and MAC mixes of the platforms compiled in, set up at startup
+static struct platform_mix platform_mix;
+
+// pick a concrete platform for ANY and MAC, among the ones compiled in
+static inline enum EPlatformType resolve_platform_type(enum EPlatformType platform_type) {
+#ifdef SINGLE_PLATFORM
+    return SINGLE_PLATFORM;
+#else
+    if (platform_type == MAC)
+        return platform_mix.mac[platform_mix.mac_len > 1 ? rand_below(platform_mix.mac_len) : 0];
+    if (platform_type != ANY)
+        return platform_type;
+    return platform_mix.any[rand_below(platform_mix.any_len)];
+#endif
+}
+
+// write a hostname for a concrete platform into buf, return its length; rank is
+// set to the hostname's position within the platform's keyspace. prefix and
+// suffix are normalized once when parsed and the generated part is valid by
+// construction, so only the label length and trailing hyphens are checked here
+static inline size_t generate_hostname(enum EPlatformType platform_type, char *buf, uint64_t *rank) {
+    char *p = buf;
+    memcpy(p, option_prefix, option_prefix_len);
+    p += option_prefix_len;
+#ifdef WITH_NAMES
+    const char *name;
+    unsigned int name_index, product;
+    size_t name_len;
+#endif
+    switch (platform_type) {
+#ifdef WITH_MACBOOK
+        case MACBOOK:
+            name = get_random_name(&name_index);
+            name_len = strlen(name);
+            product = rand_below(2);
+            memcpy(p, name, name_len); p += name_len;
+            memcpy(p, "s-Macbook-", 10); p += 10;
+            memcpy(p, product == 0 ? "Air" : "Pro", 3); p += 3;
+            *rank = (uint64_t)name_index * 2 + product;
+            break;
+#endif
+#ifdef WITH_MACMINI
+        case MACMINI:
+            name = get_random_name(&name_index);
+            name_len = strlen(name);
+            memcpy(p, name, name_len); p += name_len;
+            memcpy(p, "s-Mac-Mini", 10); p += 10;
+            *rank = name_index;
+            break;
+#endif
+#ifdef WITH_IMAC
+        case IMAC:
+            name = get_random_name(&name_index);
+            name_len = strlen(name);
+            memcpy(p, name, name_len); p += name_len;
+            memcpy(p, "s-iMac", 6); p += 6;
+            *rank = name_index;
+            break;
+#endif
+#ifdef WITH_MACSTUDIO
+        case MACSTUDIO:
+            name = get_random_name(&name_index);
+            name_len = strlen(name);
+            memcpy(p, name, name_len); p += name_len;
+            memcpy(p, "s-Mac-Studio", 12); p += 12;
+            *rank = name_index;
+            break;
+#endif
+#ifdef WITH_IPHONE
+        case IPHONE:
+            name = get_random_name(&name_index);
+            name_len = strlen(name);
+            memcpy(p, name, name_len); p += name_len;
+            memcpy(p, "s-iPhone", 8); p += 8;
+            *rank = name_index;
+            break;
+#endif
+#ifdef WITH_IPAD
+        case IPAD:
+            name = get_random_name(&name_index);
+            name_len = strlen(name);
+            memcpy(p, name, name_len); p += name_len;
+            memcpy(p, "s-iPad", 6); p += 6;
+            *rank = name_index;
+            break;
+#endif
+#ifdef WITH_LINUX
+        // the installer suggests the login name, which is lowercase
+        case LINUX:
+            name = get_random_name(&name_index);
+            product = rand_below(LINUX_MODEL_COUNT);
+            for (; *name != '\0'; name++)
+                *p++ = *name >= 'A' && *name <= 'Z' ? *name | 0x20 : *name;
+            *p++ = '-';
+            name_len = strlen(linux_models[product]);
+            memcpy(p, linux_models[product], name_len); p += name_len;
+            *rank = (uint64_t)name_index * LINUX_MODEL_COUNT + product;
+            break;
+#endif
+#ifdef WITH_ANDROID
+        // Android 8 and later name the device after its 64-bit ANDROID_ID
+        case ANDROID:
+            memcpy(p, "android-", 8); p += 8;
+            *rank = rng_next();
+            hex16(*rank, p, 'a'); p += 16;
+            break;
+#endif
+#ifdef WITH_CHROMEBOOK
+        case CHROMEBOOK:
+            memcpy(p, "chromeos-", 9); p += 9;
+            // 16 digits are written, and the last 4 left to be overwritten
+            *rank = rng_next() >> 16;
+            hex16(*rank << 16, p, 'a'); p += 12;
+            break;
+#endif
+#ifdef WITH_WINSERVER
+        case WINSERVER:
+            memcpy(p, "WIN-", 4); p += 4;
+            *rank = rand_base36(p, 11, 'A'); p += 11;
+            break;
+#endif
+#ifdef WITH_WINDOWS
+        case WINDOWS:
+            memcpy(p, "DESKTOP-", 8); p += 8;
+            *rank = rand_base36(p, 7, 'A'); p += 7;
+            break;
+#endif
+        default: break;
+    }
+    memcpy(p, option_suffix, option_suffix_len);
+    p += option_suffix_len;
+
+    size_t len = p - buf;
+    if (len > LABEL_MAX)
+        len = LABEL_MAX;
+    while (len > 0 && buf[len - 1] == '-')
+        len--;
+    return len;
+}
+
+// hostnames issued so far and excluded ones, for --unique; indexed by their
+// deletion variants as well for --min-distance
+static struct name_set issued_names;
+static struct edit_index issued_index;
+
+// an --exclude filter file, if one was given instead of a list
+static struct filter excluded_filter;
+static bool have_excluded_filter = false;
+
+// consecutive rejected candidates after which the keyspace is taken to be used up
+#define UNIQUE_ATTEMPTS 100000
+
+// record a hostname as taken; returns false if it, or with --min-distance a
+// name within that many edits of it, already was
+bool claim_hostname(const char *name, size_t len) {
+    char folded[HOSTNAME_MAX];
+    name_fold(name, len, folded);
+    // a filter only knows exact names, and now and then one it was not built from
+    if (have_excluded_filter && filter_contains(&excluded_filter, filter_key(folded, len)))
+        return false;
+    if (option_min_distance == 0)
+        return name_set_add(&issued_names, folded, len) != UINT32_MAX;
+    // exact repeats are cheaper to turn away than near ones
+    if (name_set_contains(&issued_names, folded, len) || edit_index_within(&issued_index, &issued_names, folded, len))
+        return false;
+    edit_index_add(&issued_index, &issued_names, name_set_add(&issued_names, folded, len));
+    return true;
+}
+
+// record an --exclude hostname as taken, however close it is to the others;
+// only generated names are held to --min-distance
+void exclude_hostname(const char *name, size_t len) {
+    char folded[HOSTNAME_MAX];
+    name_fold(name, len, folded);
+    uint32_t id = name_set_add(&issued_names, folded, len);
+    if (id != UINT32_MAX && option_min_distance > 0)
+        edit_index_add(&issued_index, &issued_names, id);
+}
+
+// generate_hostname(), redrawing candidates until one is unused with --unique;
+// redraws stay on the resolved platform so the mix is not skewed
+static inline size_t generate_unique_hostname(enum EPlatformType platform_type, char *buf, uint64_t *rank) {
+    size_t len = generate_hostname(platform_type, buf, rank);
+    if (!option_unique)
+        return len;
+    for (unsigned long attempts = 1; !claim_hostname(buf, len); attempts++) {
+        PROBE3(unique_reject, platform_type, buf, len);
+        METRIC_ADD(duplicate_rejections, 1);
+        if (attempts == UNIQUE_ATTEMPTS) {
+            fprintf(stderr, "hostgen: no unused %s hostname left after %d attempts\n", platform_names[platform_type], UNIQUE_ATTEMPTS);
+            exit(1);
+        }
+        len = generate_hostname(platform_type, buf, rank);
+    }
+    return len;
+}
+
+// add every hostname listed in path, one per line, to the taken ones, or map
+// path if it is a filter file from --build-filter
+void load_exclude(const char *path) {
+    size_t size;
+    if (filter_open(&excluded_filter, path)) {
+        have_excluded_filter = true;
+        return;
+    }
+    char *text = read_file(path, &size);
+    if (text == NULL) {
+        fprintf(stderr, "hostgen: %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    for (char *line = text, *next; line < text + size; line = next) {
+        next = memchr(line, '\n', text + size - line);
+        next = next != NULL ? next + 1 : text + size;
+        line += strspn(line, " \t");
+        size_t len = strcspn(line, " \t\r\n");
+        if (len == 0 || line[0] == '#')
+            continue;
+        exclude_hostname(line, len < LABEL_MAX ? len : LABEL_MAX);
+    }
+    free(text);
+}
+
+// read hostnames from stdin, one per line as for --exclude, write a filter of
+// them to path and exit; only 8 bytes per name are held while reading
+void build_filter(const char *path) {
+    uint64_t *keys = NULL;
+    size_t count = 0, keys_size = 0, line_size = 0;
+    char *line = NULL, folded[HOSTNAME_MAX];
+    while (getline(&line, &line_size, stdin) >= 0) {
+        char *name = line + strspn(line, " \t");
+        size_t len = strcspn(name, " \t\r\n");
+        if (len == 0 || name[0] == '#')
+            continue;
+        if (len > LABEL_MAX)
+            len = LABEL_MAX;
+        name_fold(name, len, folded);
+        if (count == keys_size) {
+            keys_size = keys_size != 0 ? keys_size * 2 : 65536;
+            keys = realloc(keys, keys_size * sizeof(keys[0]));
+            if (keys == NULL) {
+                perror("hostgen: malloc");
+                exit(1);
+            }
+        }
+        keys[count++] = filter_key(folded, len);
+    }
+    if (ferror(stdin)) {
+        perror("hostgen: read");
+        exit(1);
+    }
+    free(line);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "hostgen: %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    bool ok = filter_build(keys, count, option_fingerprint_bits, rng_next(), file);
+    long size = ftell(file);
+    if (fclose(file) != 0 || !ok) {
+        fprintf(stderr, "hostgen: %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    fprintf(stderr, "hostgen: %s: %zu names in %ld bytes, %.2f bits per name\n", path, count, size, count > 0 ? size * 8.0 / count : 0);
+    free(keys);
+    exit(0);
+}
+
+// where in a record the hostname goes
+static inline size_t record_name_offset(void) {
+    return option_format == BINARY ? 1 : option_format == NDJSON ? 13 : 0;
+}
+
+// write a random MAC address for a concrete platform to out as
+// xx:xx:xx:xx:xx:xx, return its length: a vendor OUI picked from the platform's
+// span of oui_table[] and a random device part, or where the platform has no
+// span, a random locally administered unicast address
+static inline size_t write_mac(enum EPlatformType platform_type, char *out) {
+    char hex[16];
+    uint64_t mac = rng_next() >> 16;
+    if (oui_spans[platform_type].count > 0)
+        mac = (uint64_t)oui_table[oui_spans[platform_type].start + rand_below(oui_spans[platform_type].count)] << 24 | (mac & 0xffffff);
+    else
+        mac = (mac & ~(UINT64_C(1) << 40)) | UINT64_C(2) << 40;
+    hex16(mac << 16, hex, 'a');
+    for (int i = 0; i < 6; i++) {
+        out[i * 3] = hex[i * 2];
+        out[i * 3 + 1] = hex[i * 2 + 1];
+        if (i < 5)
+            out[i * 3 + 2] = ':';
+    }
+    return 17;
+}
+
+// turn a hostname of len bytes, placed at record_name_offset() in buf, into a
+// record in option_format, return the record's length
+static inline size_t finish_record(enum EPlatformType platform_type, uint64_t rank, char *buf, size_t len) {
+    uint64_t record;
+    switch (option_format) {
+        case TEXT:
+            if (option_with_mac) {
+                buf[len++] = ' ';
+                len += write_mac(platform_type, buf + len);
+            }
+            buf[len++] = '\n';
+            break;
+        case BINARY:
+            buf[0] = len;
+            memset(buf + 1 + len, 0, HOSTNAME_MAX - 1 - len);
+            len = HOSTNAME_MAX;
+            break;
+        case INDEX:
+            // android and winserver ranks can be wider than 56 bits
+            record = (uint64_t)platform_type << 56 | (rank & RANK_MASK);
+            for (len = 0; len < 8; len++)
+                buf[len] = record >> (len * 8);
+            break;
+        case NDJSON:
+            memcpy(buf, "{\"hostname\":\"", 13);
+            len += 13;
+            if (option_with_mac) {
+                memcpy(buf + len, "\",\"mac\":\"", 9);
+                len += 9;
+                len += write_mac(platform_type, buf + len);
+            }
+            if (option_metadata)
+                len += sprintf(buf + len, "\",\"platform\":\"%s\",\"rank\":%llu}\n", platform_names[platform_type], (unsigned long long)rank);
+            else
+                len += sprintf(buf + len, "\"}\n");
+            break;
+        case CSV:
+            if (option_with_mac) {
+                buf[len++] = ',';
+                len += write_mac(platform_type, buf + len);
+            }
+            if (option_metadata)
+                len += sprintf(buf + len, ",%s,%llu", platform_names[platform_type], (unsigned long long)rank);
+            buf[len++] = '\n';
+            break;
+    }
+    return len;
+}
+
+// write one hostname as a record in option_format into buf, return its length
+static inline size_t generate_record(enum EPlatformType platform_type, char *buf) {
+    uint64_t rank;
+    size_t len = generate_unique_hostname(platform_type, buf + record_name_offset(), &rank);
+    return finish_record(platform_type, rank, buf, len);
+}
+
+// write out everything buffered in the sink; fd -1 discards the data
+void sink_flush(struct output_sink *sink) {
+    size_t off = 0;
+    METRIC_START(start);
+    PROBE2(flush_start, sink->fd, sink->len);
+    while (sink->fd >= 0 && off < sink->len) {
+        ssize_t ret = write(sink->fd, sink->buf + off, sink->len - off);
+        METRIC_ADD(write_calls, 1);
+        if (ret < 0 && errno == EINTR) continue;
+        // the reader went away; that is how endless runs normally end
+        if (ret < 0 && errno == EPIPE)
+            exit(0);
+        if (ret < 0) {
+            perror("hostgen: write");
+            exit(1);
+        }
+        off += ret;
+        METRIC_ADD(bytes_written, ret);
+    }
+    PROBE2(flush_done, sink->fd, off);
+    METRIC_END(PHASE_WRITE, start);
+    sink->total += sink->len;
+    sink->len = 0;
+}
+
+// generate up to count records into the sink without flushing it, return how many fit
+unsigned long fill_sink(enum EPlatformType platform_type, unsigned long count, struct output_sink *sink) {
+    unsigned long i;
+    METRIC_START(start);
+    PROBE2(generate_start, platform_type, count);
+    for (i = 0; i < count && sink->len <= SINK_SIZE - RECORD_MAX; i++) {
+        enum EPlatformType type = resolve_platform_type(platform_type);
+        METRIC_ADD(hostnames[type], 1);
+        size_t len = generate_record(type, sink->buf + sink->len);
+        PROBE3(hostname, type, sink->buf + sink->len, len);
+        sink->len += len;
+    }
+    PROBE2(generate_done, i, sink->len);
+    METRIC_END(PHASE_GENERATE, start);
+    return i;
+}
+
+// generate count records into the sink, flushing it whenever it fills up
+void generate_hostnames(enum EPlatformType platform_type, unsigned long count, struct output_sink *sink) {
+    while (count > 0) {
+        count -= fill_sink(platform_type, count, sink);
+        if (count > 0)
+            sink_flush(sink);
+    }
+}
+
+// sorter_emit callback writing a sorted hostname to the sink as a record
+void emit_sorted_record(void *ctx, const char *name, size_t len, unsigned int platform, uint64_t rank) {
+    struct output_sink *sink = ctx;
+    if (sink->len > SINK_SIZE - RECORD_MAX)
+        sink_flush(sink);
+    char *buf = sink->buf + sink->len;
+    memcpy(buf + record_name_offset(), name, len);
+    sink->len += finish_record(platform, rank, buf, len);
+}
+
+// generate count hostnames into a sorter, then write them out in order; the
+// sorter spills to temporary files beyond --mem-limit
+void generate_hostnames_sorted(enum EPlatformType platform_type, unsigned long count, struct output_sink *sink) {
+    static struct sorter sorter;
+    char name[RECORD_MAX];
+    uint64_t rank;
+
+    if (sorter.data.base == NULL)
+        sorter_init(&sorter, option_mem_limit);
+    METRIC_START(start);
+    for (unsigned long i = 0; i < count; i++) {
+        enum EPlatformType type = resolve_platform_type(platform_type);
+        METRIC_ADD(hostnames[type], 1);
+        size_t len = generate_unique_hostname(type, name, &rank);
+        sorter_add(&sorter, name, len, type, rank);
+    }
+    METRIC_END(PHASE_GENERATE, start);
+
+    METRIC_ADD(sort_runs, sorter.spill_count);
+    METRIC_START(sort_start);
+    sorter_finish(&sorter, emit_sorted_record, sink);
+    METRIC_END(PHASE_SORT, sort_start);
+}
+
+// pipeline generator thread; fills whichever sink the writer is not flushing
+void *pipeline_generate(void *arg) {
+    struct pipeline *pl = arg;
+    unsigned long remaining = pl->count;
+    rng_seed();
+    for (int i = 0; pl->count == 0 || remaining > 0; i ^= 1) {
+        METRIC_START(start);
+        pthread_mutex_lock(&pl->lock);
+        while (pl->full[i])
+            pthread_cond_wait(&pl->cond, &pl->lock);
+        pthread_mutex_unlock(&pl->lock);
+        METRIC_END(PHASE_WAIT, start);
+
+        unsigned long made = fill_sink(pl->platform_type, pl->count == 0 ? ULONG_MAX : remaining, pl->sinks[i]);
+        if (pl->count != 0)
+            remaining -= made;
+#ifdef WITH_METRICS
+        // merged per buffer, since endless runs end with exit() while we still run
+        metrics_merge();
+#endif
+
+        pthread_mutex_lock(&pl->lock);
+        pl->full[i] = true;
+        pthread_cond_signal(&pl->cond);
+        pthread_mutex_unlock(&pl->lock);
+        PROBE2(buffer_filled, i, pl->sinks[i]->len);
+    }
+    pthread_mutex_lock(&pl->lock);
+    pl->done = true;
+    pthread_cond_signal(&pl->cond);
+    pthread_mutex_unlock(&pl->lock);
+    return NULL;
+}
+
+// generate count records (endlessly if count is 0) on a separate thread while
+// the calling thread writes the previously filled buffer
+void generate_hostnames_pipelined(enum EPlatformType platform_type, unsigned long count, struct output_sink *sink) {
+    static struct output_sink spare;
+    static struct pipeline pl = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+    pthread_t generator;
+
+    spare.fd = sink->fd;
+    pl.sinks[0] = sink;
+    pl.sinks[1] = &spare;
+    pl.platform_type = platform_type;
+    pl.count = count;
+    PROBE2(pipeline_start, platform_type, count);
+    if (pthread_create(&generator, NULL, pipeline_generate, &pl) != 0) {
+        fprintf(stderr, "hostgen: cannot start generator thread\n");
+        exit(1);
+    }
+
+    for (int i = 0;; i ^= 1) {
+        METRIC_START(start);
+        pthread_mutex_lock(&pl.lock);
+        while (!pl.full[i] && !pl.done)
+            pthread_cond_wait(&pl.cond, &pl.lock);
+        bool full = pl.full[i];
+        pthread_mutex_unlock(&pl.lock);
+        METRIC_END(PHASE_WAIT, start);
+        if (!full)
+            break;
+
+        sink_flush(pl.sinks[i]);
+
+        pthread_mutex_lock(&pl.lock);
+        pl.full[i] = false;
+        pthread_cond_signal(&pl.cond);
+        pthread_mutex_unlock(&pl.lock);
+        PROBE1(buffer_drained, i);
+    }
+    pthread_join(generator, NULL);
+    PROBE0(pipeline_join);
+}
+
+// number of distinct hostnames a concrete platform can produce
+double get_platform_keyspace(enum EPlatformType platform_type) {
+    switch (platform_type) {
+#ifdef WITH_MACBOOK
+        case MACBOOK: return (double)name_count * 2;
+#endif
+#ifdef WITH_MACMINI
+        case MACMINI: return (double)name_count;
+#endif
+#ifdef WITH_WINDOWS
+        case WINDOWS: return pow(36, 7);
+#endif
+#if defined(WITH_IMAC) || defined(WITH_MACSTUDIO) || defined(WITH_IPHONE) || defined(WITH_IPAD)
+        case IMAC: case MACSTUDIO: case IPHONE: case IPAD: return (double)name_count;
+#endif
+#ifdef WITH_LINUX
+        case LINUX: return (double)name_count * LINUX_MODEL_COUNT;
+#endif
+#ifdef WITH_ANDROID
+        case ANDROID: return pow(2, 64);
+#endif
+#ifdef WITH_CHROMEBOOK
+        case CHROMEBOOK: return pow(2, 48);
+#endif
+#ifdef WITH_WINSERVER
+        case WINSERVER: return pow(36, 11);
+#endif
+        default: return 0;
+    }
+}
+
+// whether the rank of every hostname of a platform, or of every platform ANY
+// or MAC may resolve to, fits the RANK_MASK bits of an index record; android
+// and winserver ranks do not
+bool platform_fits_index(enum EPlatformType platform_type) {
+    for (int t = 0; t < PLATFORM_COUNT; t++) {
+        bool reachable = platform_type == ANY ? platform_weight(t) > 0 :
+                         platform_type == MAC ? platform_is_mac(t) && platform_enabled(t) : t == (int)platform_type;
+        if (reachable && get_platform_keyspace(t) > (double)RANK_MASK + 1)
+            return false;
+    }
+    return true;
+}
+
+// read a whole decimal number into count; false if arg is empty, has a sign,
+// blanks or anything after the digits, or overflows
+bool scan_count(const char *arg, unsigned long *count) {
+    char *end;
+    if (arg[0] < '0' || arg[0] > '9')
+        return false;
+    errno = 0;
+    *count = strtoul(arg, &end, 10);
+    return *end == '\0' && errno != ERANGE;
+}
+
+// parse a whole decimal number of at most max for the option named what
+unsigned long parse_count(const char *arg, unsigned long max, const char *what) {
+    unsigned long count;
+    if (!scan_count(arg, &count) || count > max) {
+        fprintf(stderr, "hostgen: invalid %s: '%s'\n", what, arg);
+        exit(1);
+    }
+    return count;
+}
+
+// parse a rate of hostnames per second, 0 for unpaced
+double parse_rate(const char *arg) {
+    char *end;
+    double rate = strtod(arg, &end);
+    // a record must be due within LONG_MAX nanoseconds
+    if (end == arg || *end != '\0' || !(rate >= 0 && rate < INFINITY) || (rate > 0 && rate < 1e9 / LONG_MAX)) {
+        fprintf(stderr, "hostgen: invalid rate: '%s'\n", arg);
+        exit(1);
+    }
+    return rate;
+}
+
+// print keyspace and birthday-bound collision estimates for each platform
+void display_stats(char *draws_arg) {
+    // platform mixes, in name order, weighted the same way as
+    // resolve_platform_type(); weights only count for platforms compiled in
+    static const enum EPlatformType mixes[] = {ANY, MAC, ANDROID, CHROMEBOOK, IMAC, IPAD, IPHONE, LINUX, MACBOOK, MACMINI, MACSTUDIO, WINDOWS, WINSERVER};
+    static const double default_draws[] = {1e3, 1e4, 2e5, 1e6};
+    double draws_list[4];
+    int draws_ct = 0;
+
+    if (draws_arg != NULL) {
+        char *end;
+        draws_list[draws_ct++] = strtod(draws_arg, &end);
+        if (*end != '\0' || draws_list[0] < 1) {
+            fprintf(stderr, "hostgen: invalid number of draws: '%s'\n", draws_arg);
+            exit(1);
+        }
+    } else {
+        for (; draws_ct < 4; draws_ct++)
+            draws_list[draws_ct] = default_draws[draws_ct];
+    }
+
+    printf("%-10s %20s %20s %12s %16s %12s\n", "PLATFORM", "KEYSPACE", "EFFECTIVE", "DRAWS", "E[DUPLICATES]", "P(DUPLICATE)");
+    for (unsigned int m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++) {
+        // keyspace is the union of all reachable names, the effective keyspace
+        // is 1 / sum(p^2) over every individual name and drives the birthday bound
+        double keyspace = 0, sum_p2 = 0, weight_sum = 0, weight[PLATFORM_COUNT] = {0};
+        for (int t = 0; t < PLATFORM_COUNT; t++) {
+            if (!platform_enabled(t) || t == ANY || t == MAC)
+                continue;
+            weight[t] = mixes[m] == ANY ? platform_weight(t) : mixes[m] == MAC ? platform_is_mac(t) : mixes[m] == t;
+            weight_sum += weight[t];
+        }
+        if (weight_sum == 0) continue;
+        for (int t = 0; t < PLATFORM_COUNT; t++)
+            weight[t] /= weight_sum;
+
+        for (int t = 0; t < PLATFORM_COUNT; t++) {
+            double k = get_platform_keyspace(t), w = weight[t];
+            if (w == 0) continue;
+            keyspace += k;
+            sum_p2 += w * w / k;
+        }
+        for (int d = 0; d < draws_ct; d++) {
+            double n = draws_list[d];
+            // expected distinct names after n draws: sum over names of 1 - (1 - p)^n
+            double distinct = 0;
+            for (int t = 0; t < PLATFORM_COUNT; t++) {
+                double k = get_platform_keyspace(t), w = weight[t];
+                if (w == 0) continue;
+                distinct += k * -expm1(n * log1p(-w / k));
+            }
+            double p_dupe = n > keyspace ? 1 : -expm1(-n * (n - 1) / 2 * sum_p2);
+            printf("%-10s %20.0f %20.0f %12.0f %16.2f %12.6f\n", platform_names[mixes[m]], keyspace, 1 / sum_p2, n, n - distinct, p_dupe);
+        }
+    }
+    exit(0);
+}
+
+// the time a number of seconds after start
+void timespec_after(const struct timespec *start, double seconds, struct timespec *out) {
+    double whole = floor(seconds);
+    out->tv_sec = start->tv_sec + (time_t)whole;
+    out->tv_nsec = start->tv_nsec + (long)((seconds - whole) * 1e9);
+    if (out->tv_nsec >= 1000000000) {
+        out->tv_nsec -= 1000000000;
+        out->tv_sec++;
+    }
+}
+
+// generate count records (endlessly if count is 0) at rate records per second,
+// on absolute deadlines counted from the start so that rounding never adds up:
+// below 1000 per second the n-th record is written n / rate seconds in, and
+// above that, every millisecond writes however many more are due by then
+void generate_hostnames_paced(enum EPlatformType platform_type, unsigned long count, double rate, struct output_sink *sink) {
+    bool batched = rate >= 1000;
+    unsigned long ticks = 0, sent = 0;
+    struct timespec start, deadline, now;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (true) {
+        ticks++;
+        timespec_after(&start, batched ? ticks / 1000.0 : ticks / rate, &deadline);
+        METRIC_START(start_wait);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+        METRIC_END(PHASE_WAIT, start_wait);
+
+        unsigned long batch = batched ? (unsigned long)(ticks * (rate / 1000)) - sent : 1;
+        if (count != 0 && batch > count)
+            batch = count;
+        if (batch > 0) {
+            generate_hostnames(platform_type, batch, sink);
+            sink_flush(sink);
+        }
+        sent += batch;
+        if (count != 0 && (count -= batch) == 0)
+            break;
+
+        // after a stall (slow reader, suspended process) start the schedule
+        // over instead of bursting to catch up
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec - deadline.tv_sec > 1) {
+            start = now;
+            ticks = sent = 0;
+        }
+    }
+}
+
+// seconds on the monotonic clock
+double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// time one bulk run into the given output path, return seconds and bytes produced
+double bench_run(enum EPlatformType platform_type, const char *output, unsigned long count, unsigned long long *bytes) {
+    static struct output_sink sink;
+    char tmp_path[] = "/tmp/hostgen-bench-XXXXXX";
+    int pipe_fds[2];
+    pid_t reader = -1;
+
+    sink.len = 0;
+    sink.total = 0;
+    sink.fd = -1;
+    if (strcmp(output, "file") == 0) {
+        sink.fd = mkstemp(tmp_path);
+        if (sink.fd < 0) {
+            perror("hostgen: mkstemp");
+            exit(1);
+        }
+        unlink(tmp_path);
+    } else if (strcmp(output, "pipe") == 0) {
+        // a child drains the pipe, as another program would read our stdout
+        if (pipe(pipe_fds) < 0 || (reader = fork()) < 0) {
+            perror("hostgen: pipe");
+            exit(1);
+        }
+        if (reader == 0) {
+            close(pipe_fds[1]);
+            while (read(pipe_fds[0], sink.buf, SINK_SIZE) > 0);
+            _exit(0);
+        }
+        close(pipe_fds[0]);
+        sink.fd = pipe_fds[1];
+    }
+
+    double start = get_time();
+    generate_hostnames(platform_type, count, &sink);
+    sink_flush(&sink);
+    *bytes = sink.total;
+    if (sink.fd >= 0)
+        close(sink.fd);
+    if (reader > 0)
+        waitpid(reader, NULL, 0);
+    return get_time() - start;
+}
+
+// compare doubles for qsort()
+int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// benchmark every platform and output path, print the results as JSON
+void run_bench(char *count_arg) {
+    static const enum EPlatformType platforms[] = {WINDOWS, WINSERVER, MACBOOK, MACMINI, IMAC, MACSTUDIO, IPHONE, IPAD, ANDROID, CHROMEBOOK, LINUX, MAC, ANY};
+    static const char *outputs[] = {"buffer", "file", "pipe"};
+    static const char *prngs[] = {"xoshiro256**", "chacha20"};
+    const int repetitions = 5;
+    unsigned long count = count_arg != NULL ? parse_count(count_arg, ULONG_MAX, "benchmark count") : 1000000;
+    bool first = true;
+
+    if (count == 0) {
+        fprintf(stderr, "hostgen: invalid benchmark count: '%s'\n", count_arg);
+        exit(1);
+    }
+
+    printf("{\n  \"version\": \"%s\",\n  \"count\": %lu,\n  \"repetitions\": %d,\n  \"results\": [", HOSTGEN_VERSION, count, repetitions);
+    for (unsigned int r = 0; r < sizeof(prngs) / sizeof(prngs[0]); r++)
+    for (unsigned int p = 0; p < sizeof(platforms) / sizeof(platforms[0]); p++)
+    for (unsigned int o = 0; o < sizeof(outputs) / sizeof(outputs[0]); o++) {
+        enum EPlatformType platform_type = platforms[p];
+        double secs[repetitions];
+        unsigned long long bytes;
+        if (!platform_enabled(platform_type))
+            continue;
+        option_crypto = r == 1;
+
+        // one untimed warmup pass to fault in the name table and buffers
+        bench_run(platform_type, outputs[o], count / 10 + 1, &bytes);
+        for (int i = 0; i < repetitions; i++)
+            secs[i] = bench_run(platform_type, outputs[o], count, &bytes);
+        qsort(secs, repetitions, sizeof(secs[0]), compare_double);
+
+        double median = secs[repetitions / 2];
+        printf("%s\n    {\"platform\": \"%s\", \"prng\": \"%s\", \"output\": \"%s\", "
+               "\"ns_per_hostname\": %.2f, \"min_ns_per_hostname\": %.2f, \"mb_per_sec\": %.2f}",
+               first ? "" : ",", platform_names[platform_type], prngs[r], outputs[o],
+               median * 1e9 / count, secs[0] * 1e9 / count, bytes / median / 1e6);
+        fflush(stdout);
+        first = false;
+    }
+    printf("\n  ]\n}\n");
+    exit(0);
+}
+
+// one platform's share of --check-dist: per-bin counts of what its draws
+// picked, filled in by a thread of its own. ANY and MAC count the resolved
+// platform; concrete platforms count, as read back from the hostname written,
+// the first name and the product, or every suffix digit position. a hostname
+// that cannot be read back counts as malformed
+struct dist_job {
+    enum EPlatformType platform_type;
+    unsigned long draws, malformed;
+    unsigned int products, positions, base;
+    const char *head;
+    char letter;
+    uint64_t *names, *product_counts, *digits, *platforms;
+};
+
+// the distinct names of name_list, ignoring case, for reading names back from
+// hostnames; how often each appears in name_list; and an open-addressing table
+// of their bins plus one, hashed by their folded text
+static const char **dist_names;
+static double *dist_name_weights;
+static unsigned int dist_name_count;
+static uint32_t *dist_name_slots;
+static size_t dist_name_mask;
+
+// bin of the name spelled by len bytes at name, or -1 if it is none of them;
+// with add, a new name gets the next bin instead
+int dist_name_bin(const char *name, size_t len, bool add) {
+    char folded[HOSTNAME_MAX];
+    if (len > LABEL_MAX)
+        return -1;
+    name_fold(name, len, folded);
+    for (size_t i = filter_key(folded, len) & dist_name_mask;; i = (i + 1) & dist_name_mask) {
+        uint32_t bin = dist_name_slots[i];
+        if (bin == 0 && !add)
+            return -1;
+        if (bin == 0) {
+            dist_names[dist_name_count] = name;
+            dist_name_slots[i] = ++dist_name_count;
+            return dist_name_count - 1;
+        }
+        if (strncasecmp(dist_names[bin - 1], name, len) == 0 && dist_names[bin - 1][len] == '\0')
+            return bin - 1;
+    }
+}
+
+// read the name bin and product of a hostname of a name platform back from
+// its text; returns false if it is not one that platform could have produced
+bool dist_read_name(enum EPlatformType platform_type, const char *buf, size_t len, int *bin, unsigned int *product) {
+    const char *tail = NULL;
+    size_t tail_len;
+    *product = 0;
+    switch (platform_type) {
+        case MACBOOK:
+            tail = "s-Macbook-Air";
+            if (len > 3 && memcmp(buf + len - 3, "Pro", 3) == 0)
+                tail = "s-Macbook-Pro", *product = 1;
+            break;
+        case MACMINI: tail = "s-Mac-Mini"; break;
+        case IMAC: tail = "s-iMac"; break;
+        case MACSTUDIO: tail = "s-Mac-Studio"; break;
+        case IPHONE: tail = "s-iPhone"; break;
+        case IPAD: tail = "s-iPad"; break;
+#ifdef WITH_LINUX
+        // the login name is lowercase; models are told apart by the longest
+        // one the hostname ends with
+        case LINUX:
+            tail_len = 0;
+            for (unsigned int m = 0; m < LINUX_MODEL_COUNT; m++) {
+                size_t model_len = strlen(linux_models[m]);
+                if (model_len + 1 > tail_len && len > model_len + 1 && buf[len - model_len - 1] == '-' &&
+                    memcmp(buf + len - model_len, linux_models[m], model_len) == 0) {
+                    tail_len = model_len + 1;
+                    *product = m;
+                }
+            }
+            for (size_t i = 0; i + tail_len < len; i++)
+                if (buf[i] >= 'A' && buf[i] <= 'Z')
+                    return false;
+            *bin = tail_len > 0 ? dist_name_bin(buf, len - tail_len, false) : -1;
+            return *bin >= 0;
+#endif
+        default: return false;
+    }
+    tail_len = strlen(tail);
+    if (len <= tail_len || memcmp(buf + len - tail_len, tail, tail_len) != 0)
+        return false;
+    *bin = dist_name_bin(buf, len - tail_len, false);
+    return *bin >= 0;
+}
+
+// value of a suffix digit of the given base, with letters from letter, or -1
+int dist_digit(char c, unsigned int base, char letter) {
+    int value = c >= '0' && c <= '9' ? c - '0' : c >= letter && c < letter + 26 ? c - letter + 10 : -1;
+    return value < (int)base ? value : -1;
+}
+
+// fill in a dist_job's counts
+void *dist_job_run(void *arg) {
+    struct dist_job *job = arg;
+    char buf[RECORD_MAX];
+    uint64_t rank;
+    rng_seed();
+    for (unsigned long i = 0; i < job->draws; i++) {
+        if (job->platforms != NULL) {
+            job->platforms[resolve_platform_type(job->platform_type)]++;
+            continue;
+        }
+        size_t len = generate_hostname(job->platform_type, buf, &rank);
+        if (job->names != NULL) {
+            int bin;
+            unsigned int product;
+            if (!dist_read_name(job->platform_type, buf, len, &bin, &product)) {
+                job->malformed++;
+                continue;
+            }
+            job->names[bin]++;
+            job->product_counts[product]++;
+        }
+        if (job->positions > 0) {
+            size_t head_len = strlen(job->head);
+            if (len != head_len + job->positions || memcmp(buf, job->head, head_len) != 0) {
+                job->malformed++;
+                continue;
+            }
+            for (unsigned int p = 0; p < job->positions; p++) {
+                int digit = dist_digit(buf[head_len + p], job->base, job->letter);
+                if (digit < 0) {
+                    job->malformed++;
+                    break;
+                }
+                job->digits[p * job->base + digit]++;
+            }
+        }
+    }
+    return NULL;
+}
+
+// upper quantile of the standard normal distribution for a tail of alpha,
+// found by bisection on erfc()
+double normal_quantile(double alpha) {
+    double lo = 0, hi = 40;
+    for (int i = 0; i < 100; i++) {
+        double mid = (lo + hi) / 2;
+        if (0.5 * erfc(mid / sqrt(2)) > alpha)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// chi-square test of counts against weights (uniform if NULL), over the bins
+// with a non-zero weight, at significance level alpha; prints a result line
+// and returns whether it passed
+bool check_chi_square(enum EPlatformType platform_type, const char *test, const uint64_t *counts, const double *weights, unsigned int bins, double alpha) {
+    double total = 0, weight_sum = 0, chi2 = 0;
+    unsigned int used = 0;
+    for (unsigned int b = 0; b < bins; b++) {
+        total += counts[b];
+        weight_sum += weights != NULL ? weights[b] : 1;
+    }
+    for (unsigned int b = 0; b < bins; b++) {
+        double w = weights != NULL ? weights[b] : 1, expected = total * w / weight_sum;
+        if (w == 0)
+            continue;
+        chi2 += (counts[b] - expected) * (counts[b] - expected) / expected;
+        used++;
+    }
+    // a single bin, as in the MAC mix of one Mac, cannot be off
+    if (used < 2)
+        return true;
+    // one degree of freedom is a squared normal; otherwise the upper alpha tail
+    // of chi-square by the Wilson-Hilferty approximation
+    double df = used - 1, critical, z;
+    if (used == 2) {
+        z = normal_quantile(alpha / 2);
+        critical = z * z;
+    } else {
+        z = normal_quantile(alpha);
+        critical = df * pow(1 - 2 / (9 * df) + z * sqrt(2 / (9 * df)), 3);
+    }
+    bool pass = chi2 <= critical;
+    printf("%-10s %-12s %8u %14.2f %14.2f  %s\n", platform_names[platform_type], test, used, chi2, critical, pass ? "ok" : "FAIL");
+    return pass;
+}
+
+// generate draws_arg (default 2000000) hostnames per platform and for the ANY
+// and MAC mixes, one thread each, chi-square test what was picked against the
+// intended distribution, and exit with status 1 if any test fails or any
+// hostname is malformed
+void run_check_dist(char *draws_arg) {
+    struct dist_job jobs[PLATFORM_COUNT];
+    pthread_t threads[PLATFORM_COUNT];
+    unsigned long draws = draws_arg != NULL ? parse_count(draws_arg, ULONG_MAX, "number of draws") : 2000000;
+    int job_count = 0;
+    unsigned int tests = 0;
+    bool pass = true;
+
+    if (draws == 0) {
+        fprintf(stderr, "hostgen: invalid number of draws: '%s'\n", draws_arg);
+        exit(1);
+    }
+    // the platforms' own formats are checked, without any prefix or suffix
+    option_prefix_len = option_suffix_len = 0;
+#ifdef WITH_NAMES
+    for (dist_name_mask = 1; dist_name_mask < 2 * (size_t)name_count; dist_name_mask *= 2)
+        ;
+    dist_names = malloc(name_count * sizeof(dist_names[0]));
+    dist_name_weights = calloc(name_count, sizeof(dist_name_weights[0]));
+    dist_name_slots = calloc(dist_name_mask--, sizeof(dist_name_slots[0]));
+    if (dist_names == NULL || dist_name_weights == NULL || dist_name_slots == NULL) {
+        perror("hostgen: malloc");
+        exit(1);
+    }
+    for (unsigned int i = 0; i < name_count; i++)
+        dist_name_weights[dist_name_bin(name_list[i], strlen(name_list[i]), true)]++;
+#endif
+    for (int t = 0; t < PLATFORM_COUNT; t++) {
+        struct dist_job *job = &jobs[job_count];
+        if (!platform_enabled(t))
+            continue;
+        memset(job, 0, sizeof(*job));
+        job->platform_type = t;
+        job->draws = draws;
+        switch (t) {
+            case ANY: case MAC:
+                job->platforms = calloc(PLATFORM_COUNT, sizeof(uint64_t));
+                tests++;
+                break;
+            case WINDOWS: job->head = "DESKTOP-"; job->positions = 7; job->base = 36; job->letter = 'A'; break;
+            case WINSERVER: job->head = "WIN-"; job->positions = 11; job->base = 36; job->letter = 'A'; break;
+            case ANDROID: job->head = "android-"; job->positions = 16; job->base = 16; job->letter = 'a'; break;
+            case CHROMEBOOK: job->head = "chromeos-"; job->positions = 12; job->base = 16; job->letter = 'a'; break;
+#ifdef WITH_NAMES
+            default:
+                job->products = t == MACBOOK ? 2 : 1;
+#ifdef WITH_LINUX
+                if (t == LINUX)
+                    job->products = LINUX_MODEL_COUNT;
+#endif
+                job->names = calloc(dist_name_count, sizeof(uint64_t));
+                job->product_counts = calloc(job->products, sizeof(uint64_t));
+                tests += 1 + (job->products > 1);
+                break;
+#endif
+        }
+        tests += job->positions;
+        job->digits = calloc(job->positions * job->base + 1, sizeof(uint64_t));
+        if (job->digits == NULL || ((t == ANY || t == MAC) && job->platforms == NULL) ||
+            (job->products > 0 && (job->names == NULL || job->product_counts == NULL))) {
+            perror("hostgen: malloc");
+            exit(1);
+        }
+        if (pthread_create(&threads[job_count], NULL, dist_job_run, job) != 0) {
+            perror("hostgen: pthread_create");
+            exit(1);
+        }
+        job_count++;
+    }
+
+    double alpha = CHECK_DIST_ALPHA / tests;
+    printf("%u tests at a significance level of %.3g each\n", tests, alpha);
+    printf("%-10s %-12s %8s %14s %14s  %s\n", "PLATFORM", "TEST", "BINS", "CHI2", "CRITICAL", "RESULT");
+    for (int j = 0; j < job_count; j++) {
+        struct dist_job *job = &jobs[j];
+        pthread_join(threads[j], NULL);
+        if (job->platforms != NULL) {
+            double weights[PLATFORM_COUNT];
+            for (int t = 0; t < PLATFORM_COUNT; t++)
+                weights[t] = job->platform_type == ANY ? platform_weight(t) : platform_enabled(t) && platform_is_mac(t);
+            pass &= check_chi_square(job->platform_type, "mix", job->platforms, weights, PLATFORM_COUNT, alpha);
+        }
+        if (job->names != NULL) {
+            pass &= check_chi_square(job->platform_type, "name", job->names, dist_name_weights, dist_name_count, alpha);
+            if (job->products > 1)
+                pass &= check_chi_square(job->platform_type, "product", job->product_counts, NULL, job->products, alpha);
+        }
+        for (unsigned int p = 0; p < job->positions; p++) {
+            char test[24];
+            snprintf(test, sizeof(test), "digit %u", p + 1);
+            pass &= check_chi_square(job->platform_type, test, job->digits + p * job->base, NULL, job->base, alpha);
+        }
+        if (job->malformed > 0) {
+            printf("%-10s %-12s %8s %14lu %14s  %s\n", platform_names[job->platform_type], "malformed", "", job->malformed, "0", "FAIL");
+            pass = false;
+        }
+        free(job->names);
+        free(job->product_counts);
+        free(job->digits);
+        free(job->platforms);
+    }
+    exit(pass ? 0 : 1);
+}
+
+// answer one batch job spec, which is NUL-terminated in place: whitespace
+// separated tokens, where a number is the count, key=value sets prefix, suffix,
+// platform or count for this job only, and any other word is the platform.
+// unset fields fall back to the command line options; blank lines and lines
+// starting with # are skipped. a bad spec is reported on
+// stderr and answered with no records, so later jobs keep their place
+void run_batch_job(char *line, unsigned long line_no, enum EPlatformType default_type, struct output_sink *sink) {
+    enum EPlatformType platform_type = default_type;
+    unsigned long count = option_count;
+    char *prefix = NULL, *suffix = NULL, *token, *save;
+
+    // blank lines and comments are not jobs
+    token = line + strspn(line, " \t\r");
+    if (*token == '\0' || *token == '#')
+        return;
+
+    for (token = strtok_r(line, " \t\r", &save); token != NULL; token = strtok_r(NULL, " \t\r", &save)) {
+        char *value = strchr(token, '=');
+        if (value != NULL)
+            *value++ = '\0';
+        if (value == NULL && token[0] >= '0' && token[0] <= '9')
+            value = token, token = "count";
+        else if (value == NULL)
+            value = token, token = "platform";
+
+        if (strcmp(token, "count") == 0) {
+            if (!scan_count(value, &count)) {
+                fprintf(stderr, "hostgen: stdin:%lu: invalid count: '%s'\n", line_no, value);
+                return;
+            }
+        } else if (strcmp(token, "platform") == 0) {
+            platform_type = parse_platform_type(value);
+            if (!platform_enabled(platform_type)) {
+                fprintf(stderr, "hostgen: stdin:%lu: platform not compiled in: '%s'\n", line_no, value);
+                return;
+            }
+        } else if (strcmp(token, "prefix") == 0) {
+            prefix = value;
+        } else if (strcmp(token, "suffix") == 0) {
+            suffix = value;
+        } else {
+            goto bad;
+        }
+    }
+
+    if (option_format == INDEX && !platform_fits_index(platform_type)) {
+        fprintf(stderr, "hostgen: stdin:%lu: index records cannot hold ranks of platform '%s'\n", line_no, platform_names[platform_type]);
+        return;
+    }
+
+    // per-job affixes replace the global ones for the duration of the job
+    char saved_prefix[LABEL_MAX + 1], saved_suffix[LABEL_MAX + 1];
+    size_t saved_prefix_len = option_prefix_len, saved_suffix_len = option_suffix_len;
+    memcpy(saved_prefix, option_prefix, sizeof(saved_prefix));
+    memcpy(saved_suffix, option_suffix, sizeof(saved_suffix));
+    if (prefix != NULL)
+        option_prefix_len = set_affix(prefix, option_prefix, true, "prefix");
+    if (suffix != NULL)
+        option_suffix_len = set_affix(suffix, option_suffix, false, "suffix");
+
+    PROBE3(batch_job, line_no, platform_type, count);
+    if (option_sort)
+        generate_hostnames_sorted(platform_type, count, sink);
+    else
+        generate_hostnames(platform_type, count, sink);
+
+    option_prefix_len = saved_prefix_len;
+    option_suffix_len = saved_suffix_len;
+    memcpy(option_prefix, saved_prefix, sizeof(saved_prefix));
+    memcpy(option_suffix, saved_suffix, sizeof(saved_suffix));
+    return;
+
+bad:
+    fprintf(stderr, "hostgen: stdin:%lu: bad job spec near '%s'\n", line_no, token);
+}
+
+// answer job specs read from stdin, one per line, in order. lines are scanned in
+// place in the read buffer, and output only goes out when the sink fills or
+// before blocking on more input, so a burst of jobs shares large writes while a
+// caller waiting on its answer still gets it
+void run_batch(struct output_sink *sink) {
+    static char in[BATCH_BUF_SIZE + 1];
+    enum EPlatformType default_type = set_platform_type(option_platform);
+    size_t len = 0;
+    unsigned long line_no = 0;
+    bool skipping = false, eof = false;
+
+    while (!eof) {
+        sink_flush(sink);
+        ssize_t ret = read(STDIN_FILENO, in + len, BATCH_BUF_SIZE - len);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0) {
+            perror("hostgen: read");
+            exit(1);
+        }
+        eof = ret == 0;
+        len += ret;
+
+        // answer every complete line; at eof, a final unterminated one too
+        char *line = in, *nl;
+        while (line < in + len) {
+            if ((nl = memchr(line, '\n', in + len - line)) == NULL && !eof)
+                break;
+            if (nl == NULL)
+                nl = in + len;
+            *nl = '\0';
+            line_no++;
+            if (!skipping)
+                run_batch_job(line, line_no, default_type, sink);
+            skipping = false;
+            line = nl + 1;
+        }
+        if (line > in + len)
+            line = in + len;
+        len -= line - in;
+        memmove(in, line, len);
+
+        // a line that does not fit is rejected, and dropped up to its newline
+        if (len == BATCH_BUF_SIZE) {
+            if (!skipping)
+                fprintf(stderr, "hostgen: stdin:%lu: job spec too long\n", line_no + 1);
+            skipping = true;
+            len = 0;
+        }
+    }
+}
+
+// parse a byte count with an optional K, M or G (binary) suffix
+size_t parse_size(const char *arg) {
+    char *end;
+    double size = strtod(arg, &end);
+    switch (*end) {
+        case 'k': case 'K': size *= 1 << 10; end++; break;
+        case 'm': case 'M': size *= 1 << 20; end++; break;
+        case 'g': case 'G': size *= 1 << 30; end++; break;
+    }
+    if (end == arg || *end != '\0' || size < (1 << 20)) {
+        fprintf(stderr, "hostgen: invalid size (at least 1M): '%s'\n", arg);
+        exit(1);
+    }
+    return size;
+}
+
+// fingerprint width of a filter with a false positive rate of at most arg,
+// given as a fraction or as 1/N
+unsigned int parse_fp_rate(const char *arg) {
+    char *end;
+    double rate = strtod(arg, &end);
+    if (*end == '/' && end > arg) {
+        const char *denominator = end + 1;
+        rate /= strtod(denominator, &end);
+        if (end == denominator)
+            end = (char *)arg;
+    }
+    if (end == arg || *end != '\0' || !(rate > 0 && rate < 1)) {
+        fprintf(stderr, "hostgen: invalid false positive rate: '%s'\n", arg);
+        exit(1);
+    }
+    if (rate >= 1.0 / 256)
+        return 8;
+    if (rate >= 1.0 / 65536)
+        return 16;
+    fprintf(stderr, "hostgen: false positive rate below 1/65536 not supported: '%s'\n", arg);
+    exit(1);
+}
+
+// apply one parsed option, from the command line or a config file; string
+// arguments are kept by reference, as argv, config file texts and the mapped
+// snapshot all outlive option parsing
+void apply_option(int opt, char *arg) {
+    switch (opt) {
+        case 'a': option_append = true; break;
+        case 'c': option_count = parse_count(arg, ULONG_MAX, "count"); break;
+        case 'f': option_format = set_output_format(arg); break;
+#ifdef WITH_NAMES
+        case 'l': set_locale(arg); break;
+        case 'n': load_names(arg); break;
+#endif
+        case 'o': option_output = arg; break;
+        case 'p': option_platform = arg; break;
+        case 'P': option_prefix_len = set_affix(arg, option_prefix, true, "prefix"); break;
+        case 'r': option_rate = parse_rate(arg); break;
+        case 's': option_suffix_len = set_affix(arg, option_suffix, false, "suffix"); break;
+        case OPT_BATCH_STDIN: option_batch_stdin = true; break;
+        case OPT_STATS: option_stats = true; option_stats_arg = arg; break;
+        case OPT_BENCH: option_bench = true; option_bench_arg = arg; break;
+        case OPT_CHECK_DIST: option_check_dist = true; option_check_dist_arg = arg; break;
+        case OPT_CRYPTO: option_crypto = true; break;
+        case OPT_METADATA: option_metadata = true; break;
+        case OPT_WITH_MAC: option_with_mac = true; break;
+        case OPT_METRICS: option_metrics = true; option_metrics_arg = arg; break;
+        case OPT_STREAM: option_count = 0; break;
+        case OPT_UNIQUE: option_unique = true; break;
+        case OPT_SORT: option_sort = true; break;
+        case OPT_MEM_LIMIT: option_mem_limit = parse_size(arg); break;
+        case OPT_EXCLUDE: option_unique = true; option_exclude = arg; break;
+        case OPT_BUILD_FILTER: option_build_filter = arg; break;
+        case OPT_FP_RATE: option_fingerprint_bits = parse_fp_rate(arg); break;
+        case OPT_MIN_DISTANCE: option_unique = true; option_min_distance = parse_count(arg, UINT_MAX, "minimum distance"); break;
+        default: break;
+    }
+}
+
+// fill stamp with the identity of path, or zeros if it does not exist
+void get_file_stamp(const char *path, struct file_stamp *stamp) {
+    struct stat st;
+    memset(stamp, 0, sizeof(*stamp));
+    if (path == NULL || stat(path, &st) != 0)
+        return;
+    stamp->mtime_sec = st.st_mtim.tv_sec;
+    stamp->mtime_nsec = st.st_mtim.tv_nsec;
+    stamp->size = st.st_size;
+    stamp->inode = st.st_ino;
+}
+
+// build $XDG_CONFIG_HOME/hostgen or $XDG_CACHE_HOME/hostgen/config.snapshot
+// style paths in buf, falling back to the given directory under $HOME
+bool get_user_path(char *buf, size_t size, const char *xdg_var, const char *home_dir, const char *file) {
+    const char *base = getenv(xdg_var), *home = getenv("HOME");
+    int ret;
+    if (base != NULL && base[0] != '\0')
+        ret = snprintf(buf, size, "%s/%s", base, file);
+    else if (home != NULL && home[0] != '\0')
+        ret = snprintf(buf, size, "%s/%s/%s", home, home_dir, file);
+    else
+        return false;
+    return ret > 0 && (size_t)ret < size;
+}
+
+// parse "key = value" lines of a config file into options; keys are long option
+// names, and options without an argument take no value or yes/true/1
+void parse_config(const char *path, char *text, const struct option ***options, char ***args, unsigned int *count) {
+    unsigned int line_no = 0;
+    for (char *line = text, *next; *line != '\0'; line = next) {
+        next = line + strcspn(line, "\n");
+        if (*next != '\0')
+            *next++ = '\0';
+        line_no++;
+
+        char *key = line + strspn(line, " \t"), *value = NULL;
+        if (*key == '#' || *key == '\0' || *key == '\r')
+            continue;
+        char *eq = strchr(key, '=');
+        char *key_end = eq != NULL ? eq : key + strcspn(key, "\r");
+        while (key_end > key && (key_end[-1] == ' ' || key_end[-1] == '\t'))
+            key_end--;
+        if (eq != NULL) {
+            value = eq + 1 + strspn(eq + 1, " \t");
+            char *value_end = value + strlen(value);
+            while (value_end > value && strchr(" \t\r", value_end[-1]) != NULL)
+                value_end--;
+            *value_end = '\0';
+        }
+        *key_end = '\0';
+
+        const struct option *o = long_options;
+        while (o->name != NULL && strcmp(o->name, key) != 0)
+            o++;
+        if (o->name == NULL) {
+            fprintf(stderr, "hostgen: %s:%u: unknown option '%s'\n", path, line_no, key);
+            continue;
+        }
+        if (o->has_arg == no_argument && value != NULL) {
+            if (strcmp(value, "yes") != 0 && strcmp(value, "true") != 0 && strcmp(value, "1") != 0)
+                continue;
+            value = NULL;
+        }
+        if (o->has_arg == required_argument && value == NULL) {
+            fprintf(stderr, "hostgen: %s:%u: option '%s' needs a value\n", path, line_no, key);
+            continue;
+        }
+
+        *options = realloc(*options, (*count + 1) * sizeof(**options));
+        *args = realloc(*args, (*count + 1) * sizeof(**args));
+        (*options)[*count] = o;
+        (*args)[*count] = value;
+        (*count)++;
+    }
+}
+
+// fold len bytes into an FNV-1a hash
+uint64_t fnv_mix(uint64_t hash, const void *data, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ ((const unsigned char *)data)[i]) * 0x100000001b3;
+    return hash;
+}
+
+// identity of what a snapshot means to this build: the option table, the
+// platforms compiled in and the snapshot record sizes, so that a rebuild of the
+// same version with other PLATFORMS or options does not apply another's snapshot
+uint64_t get_build_id(void) {
+    uint64_t hash = 0xcbf29ce484222325;
+    size_t sizes[] = {sizeof(struct snapshot_header), sizeof(struct snapshot_option), sizeof(struct file_stamp)};
+    for (const struct option *o = long_options; o->name != NULL; o++) {
+        hash = fnv_mix(hash, o->name, strlen(o->name) + 1);
+        hash = fnv_mix(hash, &o->has_arg, sizeof(o->has_arg));
+        hash = fnv_mix(hash, &o->val, sizeof(o->val));
+    }
+    for (int t = 0; t < PLATFORM_COUNT; t++) {
+        bool enabled = platform_enabled(t);
+        hash = fnv_mix(hash, &enabled, sizeof(enabled));
+    }
+    return fnv_mix(hash, sizes, sizeof(sizes));
+}
+
+// map a config snapshot and apply it, if it was built from exactly the config
+// files (and name list) present now; returns false if it is missing or stale
+bool load_snapshot(const char *path, const struct file_stamp *system_config, const struct file_stamp *user_config) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct snapshot_header)) {
+        close(fd);
+        return false;
+    }
+    const char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    const struct snapshot_header *header = (const void *)map;
+    struct file_stamp names_file;
+    const char *names_path = NULL;
+    int *opts = NULL;
+
+    if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION ||
+        strncmp(header->hostgen_version, HOSTGEN_VERSION, sizeof(header->hostgen_version)) != 0 ||
+        header->build_id != get_build_id() ||
+        memcmp(&header->system_config, system_config, sizeof(*system_config)) != 0 ||
+        memcmp(&header->user_config, user_config, sizeof(*user_config)) != 0 ||
+        sizeof(*header) + (uint64_t)header->option_count * sizeof(struct snapshot_option) +
+        (uint64_t)header->name_count * sizeof(uint32_t) + header->strings_size != (uint64_t)st.st_size)
+        goto stale;
+
+    const struct snapshot_option *options = (const void *)(header + 1);
+    const uint32_t *name_offsets = (const void *)(options + header->option_count);
+    const char *strings = (const char *)(name_offsets + header->name_count);
+    uint32_t strings_size = header->strings_size;
+
+    // every offset must point into the string area, which must end in a NUL,
+    // and every option name must still be one; decide before applying any
+    if (strings_size > 0 && strings[strings_size - 1] != '\0')
+        goto stale;
+    opts = malloc((header->option_count + 1) * sizeof(opts[0]));
+    if (opts == NULL)
+        goto stale;
+    for (uint32_t i = 0; i < header->option_count; i++) {
+        const struct option *o = long_options;
+        if (options[i].name >= strings_size || (options[i].arg != UINT32_MAX && options[i].arg >= strings_size))
+            goto stale;
+        while (o->name != NULL && strcmp(o->name, strings + options[i].name) != 0)
+            o++;
+        if (o->name == NULL || (o->has_arg == required_argument && options[i].arg == UINT32_MAX))
+            goto stale;
+        opts[i] = o->val;
+        if (opts[i] == 'n' && options[i].arg != UINT32_MAX)
+            names_path = strings + options[i].arg;
+    }
+    for (uint32_t i = 0; i < header->name_count; i++)
+        if (name_offsets[i] >= strings_size)
+            goto stale;
+    get_file_stamp(names_path, &names_file);
+    if (memcmp(&header->names_file, &names_file, sizeof(names_file)) != 0)
+        goto stale;
+
+    // name lists were loaded and transliterated when the snapshot was built;
+    // point name_list into the mapping instead of loading them again
+    for (uint32_t i = 0; i < header->option_count; i++) {
+        if (opts[i] == 'n' || opts[i] == 'l')
+            continue;
+        apply_option(opts[i], options[i].arg == UINT32_MAX ? NULL : (char *)strings + options[i].arg);
+    }
+    free(opts);
+#ifdef WITH_NAMES
+    if (header->name_count > 0) {
+        const char **list = malloc(header->name_count * sizeof(list[0]));
+        for (uint32_t i = 0; i < header->name_count; i++)
+            list[i] = strings + name_offsets[i];
+        name_list = list;
+        name_count = header->name_count;
+    }
+#endif
+    return true;
+
+stale:
+    free(opts);
+    munmap((void *)map, st.st_size);
+    return false;
+}
+
+// write the applied config and the name list it produced to a snapshot, through
+// a temporary file renamed into place; failures only cost the next startup time
+void save_snapshot(const char *path, const struct file_stamp *system_config, const struct file_stamp *user_config,
+                   const struct option **options, char **args, unsigned int option_count) {
+    struct snapshot_header header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, HOSTGEN_VERSION};
+    const char *names_path = NULL;
+    char *strings = NULL, tmp_path[PATH_MAX];
+    uint32_t *name_offsets = malloc(sizeof(uint32_t));
+    size_t strings_size = 0;
+
+    header.build_id = get_build_id();
+    header.system_config = *system_config;
+    header.user_config = *user_config;
+    header.option_count = option_count;
+
+    struct snapshot_option *stored = malloc((option_count + 1) * sizeof(stored[0]));
+    for (unsigned int i = 0; i < option_count; i++) {
+        size_t len = strlen(options[i]->name) + 1;
+        strings = realloc(strings, strings_size + len);
+        memcpy(strings + strings_size, options[i]->name, len);
+        stored[i].name = strings_size;
+        stored[i].arg = UINT32_MAX;
+        strings_size += len;
+        if (args[i] == NULL)
+            continue;
+        len = strlen(args[i]) + 1;
+        strings = realloc(strings, strings_size + len);
+        memcpy(strings + strings_size, args[i], len);
+        stored[i].arg = strings_size;
+        strings_size += len;
+        if (options[i]->val == 'n')
+            names_path = args[i];
+    }
+    get_file_stamp(names_path, &header.names_file);
+
+#ifdef WITH_NAMES
+    if (name_list != first_names) {
+        header.name_count = name_count;
+        name_offsets = realloc(name_offsets, (name_count + 1) * sizeof(name_offsets[0]));
+        for (unsigned int i = 0; i < name_count; i++) {
+            size_t len = strlen(name_list[i]) + 1;
+            strings = realloc(strings, strings_size + len);
+            memcpy(strings + strings_size, name_list[i], len);
+            name_offsets[i] = strings_size;
+            strings_size += len;
+        }
+    }
+#endif
+    header.strings_size = strings_size;
+
+    // create the cache directory and its parent; errors surface at open()
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
+    for (char *slash = strchr(dir + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(dir, 0700);
+        *slash = '/';
+    }
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+    FILE *file = fopen(tmp_path, "wb");
+    if (file != NULL) {
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(stored, sizeof(stored[0]), option_count, file) == option_count &&
+                  fwrite(name_offsets, sizeof(uint32_t), header.name_count, file) == header.name_count &&
+                  fwrite(strings, 1, strings_size, file) == strings_size;
+        if (fclose(file) == 0 && ok)
+            rename(tmp_path, path);
+        else
+            unlink(tmp_path);
+    }
+    free(stored);
+    free(strings);
+    free(name_offsets);
+}
+
+// apply /etc/hostgen.conf and then the per-user config file; the parsed result,
+// including any name list it loads, is cached as a snapshot next to the user's
+// other caches and mapped directly on later runs while the files are unchanged
+void load_config(void) {
+    char user_path[PATH_MAX], snapshot_path[PATH_MAX];
+    struct file_stamp system_config, user_config;
+    bool have_user = get_user_path(user_path, sizeof(user_path), "XDG_CONFIG_HOME", ".config", "hostgen");
+    bool have_snapshot = get_user_path(snapshot_path, sizeof(snapshot_path), "XDG_CACHE_HOME", ".cache", "hostgen/config.snapshot");
+
+    get_file_stamp(SYSTEM_CONFIG, &system_config);
+    get_file_stamp(have_user ? user_path : NULL, &user_config);
+    if (system_config.inode == 0 && user_config.inode == 0)
+        return;
+    if (have_snapshot && load_snapshot(snapshot_path, &system_config, &user_config))
+        return;
+
+    // the parsed options point into the file texts, which are kept for good
+    const struct option **options = NULL;
+    char **args = NULL;
+    unsigned int count = 0;
+    size_t size;
+    char *text;
+    if ((text = read_file(SYSTEM_CONFIG, &size)) != NULL)
+        parse_config(SYSTEM_CONFIG, text, &options, &args, &count);
+    if (have_user && (text = read_file(user_path, &size)) != NULL)
+        parse_config(user_path, text, &options, &args, &count);
+    for (unsigned int i = 0; i < count; i++)
+        apply_option(options[i]->val, args[i]);
+
+    if (have_snapshot)
+        save_snapshot(snapshot_path, &system_config, &user_config, options, args, count);
+    free(options);
+    free(args);
+}
+
 // main
 int main(int argc, char *argv[]) {
+    METRIC_START(setup_start);
+
     // seed rng
-    unsigned int random_seed;
-    read(fileno(fopen("/dev/urandom", "rb")), &random_seed, sizeof(random_seed));
-    srand(random_seed);
+    rng_seed();
+    platform_mix_init(&platform_mix);
 
-    // parse options
+    // defaults from the config files, unless told not to; command line options
+    // are applied on top of them
+    // are applied on top of them. a quiet first pass of getopt finds
+    // --no-config however it is spelled; errors are reported by the second
+    bool use_config = true;
     int opt, option_index = 0;
-    while ((opt = getopt_long(argc, argv, "ahn:o:p:P:s:v", long_options, &option_index)) != -1) {
-        switch (opt) {
-            case 'h': display_help_message(argv[0]); break;
-            case 'p': option_platform = strdup(optarg); break;
-            case 'v': printf("hostgen %s\n", HOSTGEN_VERSION); return 0; break;
-            default: break;
+    opterr = 0;
+    while ((opt = getopt_long(argc, argv, SHORT_OPTIONS, long_options, &option_index)) != -1)
+        if (opt == OPT_NO_CONFIG)
+            use_config = false;
+    opterr = 1;
+    optind = 0;
+    if (use_config)
+        load_config();
+
+    // parse options
+    while ((opt = getopt_long(argc, argv, SHORT_OPTIONS, long_options, &option_index)) != -1) {
+        if (opt == 'h')
+            display_help_message(argv[0]);
+        if (opt == 'v') {
+            printf("hostgen %s\n", HOSTGEN_VERSION);
+            return 0;
         }
+        apply_option(opt, optarg);
     }
 
-    // set/randomize and print the hostname
-    enum EPlatformType platform_type = set_platform_type(option_platform);
-    switch (platform_type) {
-        case MACBOOK: printf("%ss-Macbook-%s\n", get_random_name(), (rand() % 2) == 0 ? "Air" : "Pro"); break;
-        case MACMINI: printf("%ss-Mac-Mini\n", get_random_name()); break;
-        case WINDOWS: char win_rand[8]; for (int i = 0; i < 7; i++) win_rand[i] = get_random_char(true); printf("%s%s\n", "DESKTOP-", win_rand); break;
-        default: break;
+    // counters are printed however we exit, including at the end of --bench
+    // and when the reader of an endless run goes away
+    if (option_metrics) {
+        if (option_metrics_arg != NULL && strcmp(option_metrics_arg, "prometheus") != 0 && strcmp(option_metrics_arg, "json") != 0) {
+            fprintf(stderr, "hostgen: unknown metrics format: '%s'\n", option_metrics_arg);
+            exit(1);
+        }
+#ifdef WITH_METRICS
+        atexit(display_metrics);
+#else
+        fprintf(stderr, "hostgen: metrics not compiled in\n");
+        exit(1);
+#endif
+    }
+
+    if (option_build_filter != NULL)
+        build_filter(option_build_filter);
+
+    // excluded names are loaded once --min-distance is known
+    if (option_min_distance > EDIT_INDEX_MAX_DISTANCE) {
+        fprintf(stderr, "hostgen: minimum distance above %d not supported: %u\n", EDIT_INDEX_MAX_DISTANCE, option_min_distance);
+        exit(1);
     }
+    if (option_min_distance > 0)
+        edit_index_init(&issued_index, option_min_distance);
+    if (option_exclude != NULL)
+        load_exclude(option_exclude);
+    if (option_sort && !option_batch_stdin && option_count == 0) {
+        fprintf(stderr, "hostgen: --sort needs a finite --count\n");
+        exit(1);
+    }
+    if (option_with_mac && (option_format == BINARY || option_format == INDEX)) {
+        fprintf(stderr, "hostgen: --with-mac needs text, csv or ndjson output\n");
+        exit(1);
+    }
+    // a batch job may pick its own platform, and is checked on its own
+    if (option_format == INDEX && !option_batch_stdin && !platform_fits_index(set_platform_type(option_platform))) {
+        fprintf(stderr, "hostgen: index records cannot hold ranks of platform '%s'\n", platform_names[set_platform_type(option_platform)]);
+        exit(1);
+    }
+    if (option_sort && option_rate > 0) {
+        fprintf(stderr, "hostgen: --sort cannot be combined with --rate\n");
+        exit(1);
+    }
+
+    // these report on the options given, so they run once all are parsed
+    if (option_stats)
+        display_stats(option_stats_arg);
+    if (option_bench)
+        run_bench(option_bench_arg);
+    if (option_check_dist)
+        run_check_dist(option_check_dist_arg);
+
+    // open the output file, if any
+    static struct output_sink sink;
+    sink.fd = STDOUT_FILENO;
+    if (option_output != NULL) {
+        sink.fd = open(option_output, O_WRONLY | O_CREAT | (option_append ? O_APPEND : O_TRUNC), 0644);
+        if (sink.fd < 0) {
+            fprintf(stderr, "hostgen: %s: %s\n", option_output, strerror(errno));
+            return 1;
+        }
+    }
+
+    // csv gets a header line naming its columns
+    if (option_format == CSV)
+        sink.len = sprintf(sink.buf, "hostname%s%s\n", option_with_mac ? ",mac" : "", option_metadata ? ",platform,rank" : "");
+
+    // a closed pipe should surface as EPIPE from write() rather than kill us
+    signal(SIGPIPE, SIG_IGN);
+
+    METRIC_END(PHASE_SETUP, setup_start);
+
+    // set/randomize and print the hostnames
+    if (option_batch_stdin)
+        run_batch(&sink);
+    else if (option_sort)
+        generate_hostnames_sorted(set_platform_type(option_platform), option_count, &sink);
+    else if (option_rate > 0)
+        generate_hostnames_paced(set_platform_type(option_platform), option_count, option_rate, &sink);
+    else if (option_count == 0 || option_count > PIPELINE_THRESHOLD)
+        generate_hostnames_pipelined(set_platform_type(option_platform), option_count, &sink);
+    else
+        generate_hostnames(set_platform_type(option_platform), option_count, &sink);
+    sink_flush(&sink);
     return 0;
 }
@@ -262,7 +262,6 @@ static const char *first_names[] = {
     "Charli",
     "Charlie",
     "Charlotte",
-    "Chase",
     "Chelsea",
     "Cheyenne",
     "Chloe",
@@ -396,7 +395,6 @@ static const char *first_names[] = {
     "Ellie",
     "Elliot",
     "Elliott",
-    "Elias",
     "Elis",
     "Ellis",
     "Elsa",
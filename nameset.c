@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nameset.h"
+
+// slots hold the upper half of the hash over pool offset + 1; 0 is empty
+#define SLOT(hash, name) ((uint64_t)(hash) << 32 | ((name) + 1))
+
+// lowercase len bytes of name into out, which must hold len bytes
+void name_fold(const char *name, size_t len, char *out) {
+    for (size_t i = 0; i < len; i++)
+        out[i] = name[i] >= 'A' && name[i] <= 'Z' ? name[i] | 0x20 : name[i];
+}
+
+// 64-bit FNV-1a
+static uint64_t name_hash(const char *name, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char)name[i]) * 0x100000001b3;
+    return hash;
+}
+
+// double the table, or create it, and reinsert every name
+static void name_set_grow(struct name_set *set) {
+    size_t size = set->slots != NULL ? (set->mask + 1) * 2 : 1024;
+    uint64_t *slots = calloc(size, sizeof(slots[0]));
+    if (slots == NULL) {
+        perror("hostgen: malloc");
+        exit(1);
+    }
+    for (size_t i = 0; set->slots != NULL && i <= set->mask; i++) {
+        if (set->slots[i] == 0)
+            continue;
+        uint32_t name = (uint32_t)set->slots[i] - 1;
+        uint64_t hash = name_hash(name_set_str(set, name), name_set_len(set, name));
+        size_t pos = hash & (size - 1);
+        while (slots[pos] != 0)
+            pos = (pos + 1) & (size - 1);
+        slots[pos] = set->slots[i];
+    }
+    free(set->slots);
+    set->slots = slots;
+    set->mask = size - 1;
+}
+
+// find the slot holding a name, or the empty slot where it would go
+static size_t name_set_find(const struct name_set *set, const char *name, size_t len, uint64_t hash) {
+    size_t pos = hash & set->mask;
+    for (; set->slots[pos] != 0; pos = (pos + 1) & set->mask) {
+        uint32_t other = (uint32_t)set->slots[pos] - 1;
+        if (set->slots[pos] >> 32 == hash >> 32 && name_set_len(set, other) == len &&
+            memcmp(name_set_str(set, other), name, len) == 0)
+            break;
+    }
+    return pos;
+}
+
+// whether a name, already folded with name_fold(), is in the set
+bool name_set_contains(const struct name_set *set, const char *name, size_t len) {
+    return set->slots != NULL && set->slots[name_set_find(set, name, len, name_hash(name, len))] != 0;
+}
+
+// add a name of at most 255 bytes, already folded with name_fold(); returns its
+// pool offset, or UINT32_MAX if it was already in the set
+uint32_t name_set_add(struct name_set *set, const char *name, size_t len) {
+    // keep the load factor at or below a half
+    if (set->slots == NULL || set->count >= (set->mask + 1) / 2)
+        name_set_grow(set);
+
+    uint64_t hash = name_hash(name, len);
+    size_t pos = name_set_find(set, name, len, hash);
+    if (set->slots[pos] != 0)
+        return UINT32_MAX;
+
+    uint32_t offset = arena_alloc(&set->pool, len + 1);
+    char *entry = arena_at(&set->pool, offset);
+    entry[0] = len;
+    memcpy(entry + 1, name, len);
+    set->slots[pos] = SLOT(hash >> 32, offset);
+    set->count++;
+    return offset;
+}
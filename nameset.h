@@ -0,0 +1,37 @@
+#ifndef HOSTGEN_NAMESET_H
+#define HOSTGEN_NAMESET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+// set of hostnames, compared case-insensitively as DNS does; names are kept
+// lowercased in an arena, each as a length byte followed by its characters,
+// and found through an open-addressing table of their 32-bit offsets
+struct name_set {
+    struct arena pool;
+    uint64_t *slots;
+    size_t mask, count;
+};
+
+// lowercase len bytes of name into out, which must hold len bytes
+void name_fold(const char *name, size_t len, char *out);
+
+// add a name of at most 255 bytes, already folded with name_fold(); returns its
+// pool offset, or UINT32_MAX if it was already in the set
+uint32_t name_set_add(struct name_set *set, const char *name, size_t len);
+
+// whether a name, already folded with name_fold(), is in the set
+bool name_set_contains(const struct name_set *set, const char *name, size_t len);
+
+// the length and characters of the name stored at a pool offset
+static inline size_t name_set_len(const struct name_set *set, uint32_t name) {
+    return (unsigned char)*arena_at(&set->pool, name);
+}
+static inline const char *name_set_str(const struct name_set *set, uint32_t name) {
+    return arena_at(&set->pool, name) + 1;
+}
+
+#endif
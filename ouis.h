@@ -0,0 +1,68 @@
+#ifndef HOSTGEN_OUIS_H
+#define HOSTGEN_OUIS_H
+
+#include <stdint.h>
+
+#include "platforms.h"
+
+// IEEE OUIs (the first three bytes of a MAC address) that --with-mac draws
+// vendors from, in groups; each is sorted, and the groups a platform picks from
+// are adjacent, so a platform's vendors are one span of oui_table[]
+
+// Wi-Fi chipsets found in Chromebooks besides Intel's: Qualcomm Atheros, MediaTek
+#define OUIS_WIRELESS \
+    0x00037f, 0x000ce7
+
+// Intel Ethernet and Wi-Fi
+#define OUIS_INTEL \
+    0x0013e8, 0x001f3b, 0x1002b5, 0x3413e8, 0x3c970e, 0x3ca9f4, 0x3cf862, 0x4851b7, \
+    0x4c3488, 0x5ce0c5, 0x606720, 0x7c7a91, 0x8086f2, 0x8c8d28, 0xa4c3f0, 0xdc5360, \
+    0xf894c2
+
+// onboard Realtek Ethernet, under Realtek's own OUI or the board maker's: ASUSTek,
+// Gigabyte and Micro-Star
+#define OUIS_REALTEK \
+    0x00d861, 0x00e04c, 0x04d4c4, 0x1c1b0d, 0x1c872c, 0x2cfda1, 0x309c23, 0x4ccc6a, \
+    0x50e549, 0x74d435, 0xb42e99, 0xd8cb8a
+
+// server NICs and hypervisors: Broadcom, Intel server adapters, Hyper-V,
+// Supermicro, VMware and Dell
+#define OUIS_SERVER \
+    0x001018, 0x001517, 0x00155d, 0x001b21, 0x001e67, 0x002590, 0x005056, 0x141877, \
+    0x3cecef, 0x3cfdfe, 0xa0369f, 0xac1f6b
+
+// Apple
+#define OUIS_APPLE \
+    0x000393, 0x000a95, 0x0016cb, 0x0017f2, 0x001b63, 0x001ec2, 0x001ff3, 0x0023df, \
+    0x002500, 0x0026bb, 0x147dda, 0x28cfe9, 0x34363b, 0x3c0754, 0x3c22fb, 0x406c8f, \
+    0x60334b, 0x7cd1c3, 0x8c8590, 0x9801a7, 0xa45e60, 0xa860b6, 0xacbc32, 0xb8e856, \
+    0xbcd074, 0xc869cd, 0xd0817a, 0xf01898, 0xf40f24, 0xf8ffc2
+
+static const uint32_t oui_table[] = {OUIS_WIRELESS, OUIS_INTEL, OUIS_REALTEK, OUIS_SERVER, OUIS_APPLE};
+
+// entries in a group, and where the group starts in oui_table[]
+#define OUI_COUNT(...) (sizeof((const uint32_t[]){__VA_ARGS__}) / sizeof(uint32_t))
+#define OUI_WIRELESS 0
+#define OUI_INTEL (OUI_WIRELESS + OUI_COUNT(OUIS_WIRELESS))
+#define OUI_REALTEK (OUI_INTEL + OUI_COUNT(OUIS_INTEL))
+#define OUI_SERVER (OUI_REALTEK + OUI_COUNT(OUIS_REALTEK))
+#define OUI_APPLE (OUI_SERVER + OUI_COUNT(OUIS_SERVER))
+#define OUI_END (OUI_APPLE + OUI_COUNT(OUIS_APPLE))
+
+// the span of oui_table[] each platform picks a vendor from, indexed by
+// EPlatformType; phones and tablets have none, as iOS and Android use a
+// random private address on every network by default
+static const struct {
+    unsigned short start, count;
+} oui_spans[PLATFORM_COUNT] = {
+    [WINDOWS] = {OUI_INTEL, OUI_SERVER - OUI_INTEL},
+    [LINUX] = {OUI_INTEL, OUI_SERVER - OUI_INTEL},
+    [CHROMEBOOK] = {OUI_WIRELESS, OUI_REALTEK - OUI_WIRELESS},
+    [WINSERVER] = {OUI_SERVER, OUI_APPLE - OUI_SERVER},
+    [MACBOOK] = {OUI_APPLE, OUI_END - OUI_APPLE},
+    [MACMINI] = {OUI_APPLE, OUI_END - OUI_APPLE},
+    [IMAC] = {OUI_APPLE, OUI_END - OUI_APPLE},
+    [MACSTUDIO] = {OUI_APPLE, OUI_END - OUI_APPLE},
+};
+
+#endif
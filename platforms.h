@@ -0,0 +1,177 @@
+#ifndef HOSTGEN_PLATFORMS_H
+#define HOSTGEN_PLATFORMS_H
+
+#include <stdbool.h>
+
+// platforms compiled in; the Makefile defines WITH_<PLATFORM> for every entry
+// of PLATFORMS, and all of them are built when none is defined
+#if !defined(WITH_WINDOWS) && !defined(WITH_WINSERVER) && !defined(WITH_MACBOOK) && !defined(WITH_MACMINI) && \
+    !defined(WITH_IMAC) && !defined(WITH_MACSTUDIO) && !defined(WITH_IPHONE) && !defined(WITH_IPAD) && \
+    !defined(WITH_ANDROID) && !defined(WITH_CHROMEBOOK) && !defined(WITH_LINUX)
+#define WITH_WINDOWS
+#define WITH_WINSERVER
+#define WITH_MACBOOK
+#define WITH_MACMINI
+#define WITH_IMAC
+#define WITH_MACSTUDIO
+#define WITH_IPHONE
+#define WITH_IPAD
+#define WITH_ANDROID
+#define WITH_CHROMEBOOK
+#define WITH_LINUX
+#endif
+
+// platforms that pick from first_names[]
+#if defined(WITH_MACBOOK) || defined(WITH_MACMINI) || defined(WITH_IMAC) || defined(WITH_MACSTUDIO) || \
+    defined(WITH_IPHONE) || defined(WITH_IPAD) || defined(WITH_LINUX)
+#define WITH_NAMES
+#endif
+
+// Mac computers, which MAC picks among
+#if defined(WITH_MACBOOK) || defined(WITH_MACMINI) || defined(WITH_IMAC) || defined(WITH_MACSTUDIO)
+#define WITH_ANY_MAC
+#endif
+
+// platform type enum; ANY and MAC are resolved per hostname. the values are
+// the platform ids of index records, so new platforms go at the end
+enum EPlatformType { ANY, WINDOWS, MACBOOK, MACMINI, MAC, IMAC, MACSTUDIO, IPHONE, IPAD, ANDROID, CHROMEBOOK, LINUX, WINSERVER, PLATFORM_COUNT };
+
+// relative weights of the platforms in the ANY mix
+#define WEIGHT_WINDOWS 11
+#define WEIGHT_MACBOOK 4
+#define WEIGHT_MACMINI 1
+#define WEIGHT_IMAC 1
+#define WEIGHT_MACSTUDIO 1
+#define WEIGHT_IPHONE 6
+#define WEIGHT_IPAD 2
+#define WEIGHT_ANDROID 5
+#define WEIGHT_CHROMEBOOK 2
+#define WEIGHT_LINUX 1
+#define WEIGHT_WINSERVER 1
+
+// room for every platform repeated by its weight
+#define PLATFORM_MIX_MAX 64
+
+// with a single platform compiled in, resolving a platform is a constant and
+// the generator switch folds down to one case
+#if defined(WITH_WINDOWS) + defined(WITH_WINSERVER) + defined(WITH_MACBOOK) + defined(WITH_MACMINI) + \
+    defined(WITH_IMAC) + defined(WITH_MACSTUDIO) + defined(WITH_IPHONE) + defined(WITH_IPAD) + \
+    defined(WITH_ANDROID) + defined(WITH_CHROMEBOOK) + defined(WITH_LINUX) == 1
+#if defined(WITH_WINDOWS)
+#define SINGLE_PLATFORM WINDOWS
+#elif defined(WITH_WINSERVER)
+#define SINGLE_PLATFORM WINSERVER
+#elif defined(WITH_MACBOOK)
+#define SINGLE_PLATFORM MACBOOK
+#elif defined(WITH_MACMINI)
+#define SINGLE_PLATFORM MACMINI
+#elif defined(WITH_IMAC)
+#define SINGLE_PLATFORM IMAC
+#elif defined(WITH_MACSTUDIO)
+#define SINGLE_PLATFORM MACSTUDIO
+#elif defined(WITH_IPHONE)
+#define SINGLE_PLATFORM IPHONE
+#elif defined(WITH_IPAD)
+#define SINGLE_PLATFORM IPAD
+#elif defined(WITH_ANDROID)
+#define SINGLE_PLATFORM ANDROID
+#elif defined(WITH_CHROMEBOOK)
+#define SINGLE_PLATFORM CHROMEBOOK
+#else
+#define SINGLE_PLATFORM LINUX
+#endif
+#endif
+
+#ifdef WITH_LINUX
+// machine names that Ubuntu's installer appends to the user name, taken from
+// the DMI product name (or the version, on Lenovo machines) with spaces as hyphens
+static const char *const linux_models[] = {
+    "ThinkPad-X1-Carbon", "ThinkPad-X1", "ThinkPad-T14", "ThinkPad-T480", "ThinkPad-E14", "ThinkPad-P52",
+    "Latitude-5420", "Latitude-7490", "XPS-13-9310", "XPS-15-9570", "Inspiron-15-3511", "OptiPlex-7090",
+    "Precision-5560", "Vostro-3510", "HP-EliteBook-840-G8", "HP-ProBook-450-G8", "HP-Pavilion-Laptop-15",
+    "ZenBook-UX425EA", "VivoBook-15", "IdeaPad-5-14ALC05", "Aspire-A515-54", "Surface-Laptop-3",
+    "Framework-Laptop", "VirtualBox",
+};
+#define LINUX_MODEL_COUNT (sizeof(linux_models) / sizeof(linux_models[0]))
+#endif
+
+// whether a platform is compiled in; MAC needs any Mac platform
+static inline bool platform_enabled(enum EPlatformType platform_type) {
+    switch (platform_type) {
+        case ANY: return true;
+#ifdef WITH_ANY_MAC
+        case MAC: return true;
+#endif
+#ifdef WITH_WINDOWS
+        case WINDOWS: return true;
+#endif
+#ifdef WITH_WINSERVER
+        case WINSERVER: return true;
+#endif
+#ifdef WITH_MACBOOK
+        case MACBOOK: return true;
+#endif
+#ifdef WITH_MACMINI
+        case MACMINI: return true;
+#endif
+#ifdef WITH_IMAC
+        case IMAC: return true;
+#endif
+#ifdef WITH_MACSTUDIO
+        case MACSTUDIO: return true;
+#endif
+#ifdef WITH_IPHONE
+        case IPHONE: return true;
+#endif
+#ifdef WITH_IPAD
+        case IPAD: return true;
+#endif
+#ifdef WITH_ANDROID
+        case ANDROID: return true;
+#endif
+#ifdef WITH_CHROMEBOOK
+        case CHROMEBOOK: return true;
+#endif
+#ifdef WITH_LINUX
+        case LINUX: return true;
+#endif
+        default: return false;
+    }
+}
+
+// whether a platform is one of the Mac computers MAC picks among
+static inline bool platform_is_mac(enum EPlatformType platform_type) {
+    return platform_type == MACBOOK || platform_type == MACMINI || platform_type == IMAC || platform_type == MACSTUDIO;
+}
+
+// weight of a platform in the ANY mix; 0 if it is not compiled in, or is
+// ANY or MAC themselves
+static inline unsigned int platform_weight(enum EPlatformType platform_type) {
+    static const unsigned char weights[PLATFORM_COUNT] = {
+        [WINDOWS] = WEIGHT_WINDOWS, [MACBOOK] = WEIGHT_MACBOOK, [MACMINI] = WEIGHT_MACMINI,
+        [IMAC] = WEIGHT_IMAC, [MACSTUDIO] = WEIGHT_MACSTUDIO, [IPHONE] = WEIGHT_IPHONE,
+        [IPAD] = WEIGHT_IPAD, [ANDROID] = WEIGHT_ANDROID, [CHROMEBOOK] = WEIGHT_CHROMEBOOK,
+        [LINUX] = WEIGHT_LINUX, [WINSERVER] = WEIGHT_WINSERVER,
+    };
+    return platform_enabled(platform_type) ? weights[platform_type] : 0;
+}
+
+// ANY and MAC resolved with a single bounded draw: the platforms compiled in,
+// each repeated by its weight, and the Macs compiled in, once each
+struct platform_mix {
+    unsigned char any[PLATFORM_MIX_MAX], mac[4];
+    unsigned int any_len, mac_len;
+};
+
+// fill in a platform_mix for the platforms compiled in
+static inline void platform_mix_init(struct platform_mix *mix) {
+    mix->any_len = mix->mac_len = 0;
+    for (int t = 0; t < PLATFORM_COUNT; t++) {
+        for (unsigned int w = platform_weight(t); w > 0; w--)
+            mix->any[mix->any_len++] = t;
+        if (platform_is_mac(t) && platform_enabled(t))
+            mix->mac[mix->mac_len++] = t;
+    }
+}
+
+#endif
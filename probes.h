@@ -0,0 +1,28 @@
+#ifndef HOSTGEN_PROBES_H
+#define HOSTGEN_PROBES_H
+
+// static tracepoints (USDT) for perf and bpftrace, e.g.
+//   bpftrace -e 'usdt:./hostgen:hostgen:flush_done { @[arg0] = count(); }'
+// a probe is a single nop and a note in the binary until a tracer attaches,
+// so they stay in normal builds. they need <sys/sdt.h> from systemtap; without
+// it, or with PROBES=no, they compile to nothing
+#if !defined(NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define WITH_PROBES
+#endif
+#endif
+
+#ifdef WITH_PROBES
+#define PROBE0(name) STAP_PROBE(hostgen, name)
+#define PROBE1(name, a) STAP_PROBE1(hostgen, name, a)
+#define PROBE2(name, a, b) STAP_PROBE2(hostgen, name, a, b)
+#define PROBE3(name, a, b, c) STAP_PROBE3(hostgen, name, a, b, c)
+#else
+#define PROBE0(name) ((void)0)
+#define PROBE1(name, a) ((void)0)
+#define PROBE2(name, a, b) ((void)0)
+#define PROBE3(name, a, b, c) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,420 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "sorter.h"
+#include "probes.h"
+
+// bytes around each packed name: its length, platform and rank
+#define ENTRY_OVERHEAD 10
+
+// below this many names, insertion sort beats another radix pass
+#define INSERTION_SORT_MAX 32
+
+// largest and smallest buffer for a run file being written or merged
+#define RUN_BUFFER_SIZE 65536
+#define RUN_BUFFER_MIN 4096
+
+// file descriptors left to the rest of the program
+#define SPARE_FDS 16
+
+// a buffered run file being written
+struct run_writer {
+    int fd;
+    char *buf;
+    size_t len, size;
+};
+
+// the next name of a run, or of the in-memory batch (fd < 0), during a merge
+struct sorter_source {
+    int fd;
+    char *buf;
+    size_t pos, len, next;
+    unsigned char len_byte;
+    unsigned char platform;
+    uint64_t rank;
+    char name[256];
+};
+
+// exit on a failed allocation or temporary file operation
+static void sorter_fail(const char *what) {
+    perror(what);
+    exit(1);
+}
+
+// allocate or exit
+static void *sorter_alloc(size_t size) {
+    void *p = malloc(size);
+    if (p == NULL)
+        sorter_fail("hostgen: malloc");
+    return p;
+}
+
+// set up an empty sorter using about mem_limit bytes of memory, run buffers
+// included, and within the open file limit. an eighth of the budget buffers
+// merges, of fan_in runs and the run they are merged into; the rest goes three
+// quarters to packed names and a quarter to two offset arrays
+void sorter_init(struct sorter *s, size_t mem_limit) {
+    size_t merge_budget = mem_limit / 8, data_limit = mem_limit - merge_budget, fds = 1024;
+    size_t data_size = data_limit / 4 * 3;
+    struct rlimit rl;
+    memset(s, 0, sizeof(*s));
+
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+        fds = rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur > 65536 ? 65536 : rl.rlim_cur;
+    s->max_runs = fds > SPARE_FDS + 3 ? fds - SPARE_FDS : 3;
+    s->fan_in = merge_budget / RUN_BUFFER_MIN - 1;
+    if (s->fan_in > s->max_runs - 1)
+        s->fan_in = s->max_runs - 1;
+    if (s->fan_in < 2)
+        s->fan_in = 2;
+    s->run_buffer = merge_budget / (s->fan_in + 1);
+    if (s->run_buffer > RUN_BUFFER_SIZE)
+        s->run_buffer = RUN_BUFFER_SIZE;
+    if (s->run_buffer < RUN_BUFFER_MIN)
+        s->run_buffer = RUN_BUFFER_MIN;
+
+    // names are addressed by 32-bit offsets
+    arena_reserve(&s->data, data_size < UINT32_MAX ? data_size : UINT32_MAX);
+    s->offsets_size = data_limit / 4 / (2 * sizeof(uint32_t));
+    s->offsets = sorter_alloc(s->offsets_size * sizeof(uint32_t));
+    s->scratch = sorter_alloc(s->offsets_size * sizeof(uint32_t));
+    s->runs = sorter_alloc(s->max_runs * sizeof(s->runs[0]));
+}
+
+// byte of an entry's name at depth, shifted up by one so the end of a shorter
+// name (0) sorts before any character
+static inline unsigned int key_at(const char *data, uint32_t entry, size_t depth) {
+    unsigned char len = data[entry];
+    return depth < len ? (unsigned char)data[entry + 1 + depth] + 1 : 0;
+}
+
+// order two entries by name, looking from depth on
+static int compare_entries(const char *data, uint32_t a, uint32_t b, size_t depth) {
+    size_t len_a = (unsigned char)data[a], len_b = (unsigned char)data[b];
+    size_t len = len_a < len_b ? len_a : len_b;
+    int cmp = len > depth ? memcmp(data + a + 1 + depth, data + b + 1 + depth, len - depth) : 0;
+    return cmp != 0 ? cmp : (len_a > len_b) - (len_a < len_b);
+}
+
+// most-significant-digit radix sort of entry offsets by name; every pass
+// distributes the entries by their byte at depth, and buckets are sorted on
+// the following byte. names of one platform share long stretches (all Windows
+// names start with DESKTOP-), which are skipped without a pass of their own
+static void radix_sort(const char *data, uint32_t *a, uint32_t *scratch, size_t n, size_t depth) {
+    size_t count[257];
+    if (n > INSERTION_SORT_MAX) {
+        // step over the bytes all names share in one pass, rather than a
+        // counting pass per byte
+        const char *first = data + a[0] + 1;
+        size_t common = (unsigned char)data[a[0]];
+        for (size_t i = 1; i < n && common > depth; i++) {
+            const char *other = data + a[i] + 1;
+            size_t len = (unsigned char)data[a[i]], d = depth;
+            if (len < common)
+                common = len;
+            while (d < common && other[d] == first[d])
+                d++;
+            common = d;
+        }
+        if (common > depth)
+            depth = common;
+
+        memset(count, 0, sizeof(count));
+        for (size_t i = 0; i < n; i++)
+            count[key_at(data, a[i], depth)]++;
+        // names that ended here are equal; nothing is left to order
+        if (count[0] == n)
+            return;
+
+        size_t pos[257], sum = 0;
+        for (int b = 0; b < 257; b++) {
+            pos[b] = sum;
+            sum += count[b];
+        }
+        for (size_t i = 0; i < n; i++)
+            scratch[pos[key_at(data, a[i], depth)]++] = a[i];
+        memcpy(a, scratch, n * sizeof(a[0]));
+
+        for (size_t b = 1, start = count[0]; b < 257; start += count[b++])
+            if (count[b] > 1)
+                radix_sort(data, a + start, scratch, count[b], depth + 1);
+        return;
+    }
+
+    for (size_t i = 1; i < n; i++) {
+        uint32_t entry = a[i];
+        size_t j = i;
+        for (; j > 0 && compare_entries(data, a[j - 1], entry, depth) > 0; j--)
+            a[j] = a[j - 1];
+        a[j] = entry;
+    }
+}
+
+// open a new unlinked temporary file for a run, with a buffer to write it through
+static void run_writer_open(struct sorter *s, struct run_writer *w) {
+    char path[4096];
+    const char *tmpdir = getenv("TMPDIR");
+    snprintf(path, sizeof(path), "%s/hostgen-sort-XXXXXX", tmpdir != NULL && tmpdir[0] != '\0' ? tmpdir : "/tmp");
+    w->fd = mkstemp(path);
+    if (w->fd < 0)
+        sorter_fail("hostgen: sort: temporary file");
+    unlink(path);
+    w->buf = sorter_alloc(s->run_buffer);
+    w->len = 0;
+    w->size = s->run_buffer;
+}
+
+// write out what a run writer holds
+static void run_writer_flush(struct run_writer *w) {
+    for (size_t off = 0; off < w->len;) {
+        ssize_t ret = write(w->fd, w->buf + off, w->len - off);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret < 0)
+            sorter_fail("hostgen: sort: temporary file");
+        off += ret;
+    }
+    w->len = 0;
+}
+
+// append one packed entry to a run
+static void run_writer_put(struct run_writer *w, const char *entry, size_t len) {
+    if (w->len + len > w->size)
+        run_writer_flush(w);
+    memcpy(w->buf + w->len, entry, len);
+    w->len += len;
+}
+
+// finish a run and add it to the sorter's runs
+static void run_writer_close(struct sorter *s, struct run_writer *w, unsigned int level) {
+    run_writer_flush(w);
+    free(w->buf);
+    s->runs[s->run_count].fd = w->fd;
+    s->runs[s->run_count++].level = level;
+}
+
+static void sorter_compact(struct sorter *s);
+
+// sort the names in memory and write them to a new run file
+static void sorter_spill(struct sorter *s) {
+    struct run_writer w;
+    PROBE2(sort_spill, s->run_count, s->count);
+    radix_sort(s->data.base, s->offsets, s->scratch, s->count, 0);
+    run_writer_open(s, &w);
+    for (size_t i = 0; i < s->count; i++) {
+        const char *entry = arena_at(&s->data, s->offsets[i]);
+        run_writer_put(&w, entry, (unsigned char)entry[0] + ENTRY_OVERHEAD);
+    }
+    run_writer_close(s, &w, 0);
+    s->spill_count++;
+    arena_reset(&s->data);
+    s->count = 0;
+    sorter_compact(s);
+}
+
+// add a name of at most 255 bytes
+void sorter_add(struct sorter *s, const char *name, size_t len, unsigned int platform, uint64_t rank) {
+    // spill rather than let the arena grow past its reserved budget
+    if (s->data.used + len + ENTRY_OVERHEAD > s->data.size || s->count == s->offsets_size)
+        sorter_spill(s);
+    uint32_t offset = arena_alloc(&s->data, len + ENTRY_OVERHEAD);
+    char *entry = arena_at(&s->data, offset);
+    entry[0] = len;
+    memcpy(entry + 1, name, len);
+    entry[1 + len] = platform;
+    memcpy(entry + 2 + len, &rank, sizeof(rank));
+    s->offsets[s->count++] = offset;
+}
+
+// copy n bytes of a run into out, refilling the source's buffer as needed;
+// returns false at the end of the run
+static bool source_read(struct sorter_source *src, void *out, size_t n) {
+    char *dst = out;
+    while (n > 0) {
+        if (src->pos == src->len) {
+            ssize_t ret = read(src->fd, src->buf, src->next);
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret < 0)
+                sorter_fail("hostgen: sort: temporary file");
+            if (ret == 0)
+                return false;
+            src->pos = 0;
+            src->len = ret;
+        }
+        size_t chunk = src->len - src->pos < n ? src->len - src->pos : n;
+        memcpy(dst, src->buf + src->pos, chunk);
+        src->pos += chunk;
+        dst += chunk;
+        n -= chunk;
+    }
+    return true;
+}
+
+// load the next name of a source; returns false once it is used up. for a run,
+// next is the size of its buffer; for the in-memory batch, the next offset
+static bool source_next(struct sorter *s, struct sorter_source *src) {
+    char tail[1 + sizeof(uint64_t)];
+    if (src->fd < 0) {
+        if (src->next == s->count)
+            return false;
+        const char *entry = arena_at(&s->data, s->offsets[src->next++]);
+        src->len_byte = entry[0];
+        memcpy(src->name, entry + 1, src->len_byte);
+        memcpy(tail, entry + 1 + src->len_byte, sizeof(tail));
+    } else {
+        if (!source_read(src, &src->len_byte, 1))
+            return false;
+        if (!source_read(src, src->name, src->len_byte) || !source_read(src, tail, sizeof(tail))) {
+            errno = EIO;
+            sorter_fail("hostgen: sort: temporary file");
+        }
+    }
+    src->platform = tail[0];
+    memcpy(&src->rank, tail + 1, sizeof(src->rank));
+    return true;
+}
+
+// order two sources by their current name
+static bool source_less(const struct sorter_source *a, const struct sorter_source *b) {
+    size_t len = a->len_byte < b->len_byte ? a->len_byte : b->len_byte;
+    int cmp = memcmp(a->name, b->name, len);
+    return cmp != 0 ? cmp < 0 : a->len_byte < b->len_byte;
+}
+
+// restore the min-heap order below position i
+static void heap_down(struct sorter_source **heap, size_t n, size_t i) {
+    while (true) {
+        size_t least = i, l = 2 * i + 1, r = l + 1;
+        if (l < n && source_less(heap[l], heap[least]))
+            least = l;
+        if (r < n && source_less(heap[r], heap[least]))
+            least = r;
+        if (least == i)
+            return;
+        struct sorter_source *t = heap[i];
+        heap[i] = heap[least];
+        heap[least] = t;
+        i = least;
+    }
+}
+
+// merge sources (runs from their start) through a binary heap, calling emit
+// for every name once
+static void sorter_merge(struct sorter *s, struct sorter_source *sources, size_t count, sorter_emit emit, void *ctx) {
+    struct sorter_source **heap = sorter_alloc((count + 1) * sizeof(heap[0]));
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+        if (source_next(s, &sources[i]))
+            heap[n++] = &sources[i];
+    for (size_t i = n / 2; i-- > 0;)
+        heap_down(heap, n, i);
+
+    char last[256];
+    int last_len = -1;
+    while (n > 0) {
+        struct sorter_source *top = heap[0];
+        if (top->len_byte != last_len || memcmp(top->name, last, top->len_byte) != 0) {
+            emit(ctx, top->name, top->len_byte, top->platform, top->rank);
+            memcpy(last, top->name, top->len_byte);
+            last_len = top->len_byte;
+        }
+        if (!source_next(s, top))
+            heap[0] = heap[--n];
+        heap_down(heap, n, 0);
+    }
+    free(heap);
+}
+
+// set up sources for the runs from first on, each read from its start through
+// a buffer of its own, and the in-memory batch after them if with_batch
+static struct sorter_source *open_sources(struct sorter *s, size_t first, bool with_batch) {
+    size_t count = s->run_count - first;
+    struct sorter_source *sources = calloc(count + 1, sizeof(sources[0]));
+    if (sources == NULL)
+        sorter_fail("hostgen: malloc");
+    for (size_t i = 0; i < count; i++) {
+        sources[i].fd = s->runs[first + i].fd;
+        sources[i].buf = sorter_alloc(s->run_buffer);
+        sources[i].next = s->run_buffer;
+        if (lseek(sources[i].fd, 0, SEEK_SET) != 0)
+            sorter_fail("hostgen: sort: temporary file");
+    }
+    sources[count].fd = -1;
+    sources[count].next = with_batch ? 0 : s->count;
+    return sources;
+}
+
+// close the runs from first on and free their sources
+static void close_sources(struct sorter *s, struct sorter_source *sources, size_t first) {
+    for (size_t i = 0; i < s->run_count - first; i++) {
+        close(sources[i].fd);
+        free(sources[i].buf);
+    }
+    free(sources);
+    s->run_count = first;
+}
+
+// sorter_emit callback appending a name to a run
+static void emit_to_run(void *ctx, const char *name, size_t len, unsigned int platform, uint64_t rank) {
+    char entry[256 + ENTRY_OVERHEAD];
+    entry[0] = len;
+    memcpy(entry + 1, name, len);
+    entry[1 + len] = platform;
+    memcpy(entry + 2 + len, &rank, sizeof(rank));
+    run_writer_put(ctx, entry, len + ENTRY_OVERHEAD);
+}
+
+// merge the last count runs into one
+static void merge_runs(struct sorter *s, size_t count) {
+    size_t first = s->run_count - count;
+    unsigned int level = 0;
+    struct run_writer w;
+    for (size_t i = first; i < s->run_count; i++)
+        if (s->runs[i].level >= level)
+            level = s->runs[i].level + 1;
+    PROBE2(sort_merge, count, 0);
+    struct sorter_source *sources = open_sources(s, first, false);
+    run_writer_open(s, &w);
+    sorter_merge(s, sources, count, emit_to_run, &w);
+    close_sources(s, sources, first);
+    run_writer_close(s, &w, level);
+}
+
+// merge runs as they pile up: fan_in runs of one level become one of the next,
+// so every name is rewritten about log(runs) / log(fan_in) times; and whatever
+// the levels, enough are merged to leave descriptors for the next spill and
+// its merge
+static void sorter_compact(struct sorter *s) {
+    while (true) {
+        bool full = s->run_count + 2 > s->max_runs, tier = s->run_count >= s->fan_in;
+        for (size_t i = s->run_count - s->fan_in; tier && i < s->run_count; i++)
+            tier = s->runs[i].level == s->runs[s->run_count - 1].level;
+        if (!full && !tier)
+            return;
+        merge_runs(s, s->run_count < s->fan_in ? s->run_count : s->fan_in);
+    }
+}
+
+// emit everything added in order, dropping repeats of a name, and empty the
+// sorter for reuse
+void sorter_finish(struct sorter *s, sorter_emit emit, void *ctx) {
+    radix_sort(s->data.base, s->offsets, s->scratch, s->count, 0);
+
+    // earlier passes bring the runs down to fan_in, newest and smallest first;
+    // the last one merges them with the in-memory batch
+    while (s->run_count > s->fan_in)
+        merge_runs(s, s->fan_in);
+    PROBE2(sort_merge, s->run_count, s->count);
+    struct sorter_source *sources = open_sources(s, 0, true);
+    sorter_merge(s, sources, s->run_count + 1, emit, ctx);
+    close_sources(s, sources, 0);
+
+    s->spill_count = 0;
+    arena_reset(&s->data);
+    s->count = 0;
+}
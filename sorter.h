@@ -0,0 +1,48 @@
+#ifndef HOSTGEN_SORTER_H
+#define HOSTGEN_SORTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
+
+// sorts hostnames (with their platform and rank) in byte order within a memory
+// budget. names are packed back to back in an arena, each as a length byte,
+// the name, a platform byte and an 8-byte rank, and sorted by radix sort over
+// 32-bit offsets. when the budget is used up, the sorted batch is spilled to a
+// temporary file as a run. runs are merged a few at a time as they pile up, so
+// that neither their file descriptors nor their merge buffers outgrow the
+// limits, and the last of them when the output is read back
+struct sorter {
+    struct arena data;
+    uint32_t *offsets, *scratch;
+    size_t count, offsets_size;
+    struct sorter_run *runs;
+    size_t run_count, spill_count;
+    // runs merged at once, most runs open at once, and the buffer each gets
+    size_t fan_in, max_runs, run_buffer;
+};
+
+// a sorted run in an unlinked temporary file; level counts the merges its
+// names went through
+struct sorter_run {
+    int fd;
+    unsigned int level;
+};
+
+// called for every name in order, once per distinct name
+typedef void (*sorter_emit)(void *ctx, const char *name, size_t len, unsigned int platform, uint64_t rank);
+
+// set up an empty sorter using about mem_limit bytes of memory, run buffers
+// included, and within the open file limit
+void sorter_init(struct sorter *s, size_t mem_limit);
+
+// add a name of at most 255 bytes
+void sorter_add(struct sorter *s, const char *name, size_t len, unsigned int platform, uint64_t rank);
+
+// emit everything added in order, dropping repeats of a name, and empty the
+// sorter for reuse
+void sorter_finish(struct sorter *s, sorter_emit emit, void *ctx);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef HOSTGEN_SUFFIX_H
+#define HOSTGEN_SUFFIX_H
+
+#include <stdint.h>
+
+// most base-36 digits one 64-bit random number can fill without bias
+#define BASE36_MAX_DIGITS 12
+
+// powers of 36 up to 36^BASE36_MAX_DIGITS, the keyspace of that many digits
+static const uint64_t base36_pow[BASE36_MAX_DIGITS + 1] = {
+    1ULL, 36ULL, 1296ULL, 46656ULL, 1679616ULL, 60466176ULL, 2176782336ULL,
+    78364164096ULL, 2821109907456ULL, 101559956668416ULL, 3656158440062976ULL,
+    131621703842267136ULL, 4738381338321616896ULL,
+};
+
+// write the 16 hex digits of x to out, most significant first, with letters
+// from letter ('a' or 'A'). the nibbles are spread one per byte and turned into
+// ASCII eight at a time within a 64-bit word: 0-9 get '0' added, and 10-15,
+// found by the carry out of adding 6, get the distance to letter on top
+static inline void hex16(uint64_t x, char *out, char letter) {
+    for (int half = 0; half < 2; half++) {
+        uint64_t v = half == 0 ? x >> 32 : (uint32_t)x;
+        v = (v | v << 16) & 0x0000ffff0000ffffULL;
+        v = (v | v << 8) & 0x00ff00ff00ff00ffULL;
+        v = (v | v << 4) & 0x0f0f0f0f0f0f0f0fULL;
+        uint64_t letters = ((v + 0x0606060606060606ULL) & 0x1010101010101010ULL) >> 4;
+        v += 0x3030303030303030ULL + letters * (uint64_t)(letter - '0' - 10);
+        // the least significant nibble is now in the lowest byte
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        v = __builtin_bswap64(v);
+#endif
+        __builtin_memcpy(out + half * 8, &v, 8);
+    }
+}
+
+// write the first count (at most BASE36_MAX_DIGITS) base-36 digits of the
+// fraction r / 2^64 to out, with letters from letter: each digit is the high
+// half of r * 36, and the low half carries on to the next one. the digits
+// spell out r * 36^count / 2^64, so a multiply-shift bounded draw of r (see
+// rand_below()) makes every digit string equally likely
+static inline void base36_digits(uint64_t r, int count, char *out, char letter) {
+    for (int i = 0; i < count; i++) {
+        unsigned __int128 t = (unsigned __int128)r * 36;
+        unsigned int digit = t >> 64;
+        r = (uint64_t)t;
+        out[i] = digit < 10 ? '0' + digit : letter + digit - 10;
+    }
+}
+
+#endif
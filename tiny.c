@@ -0,0 +1,366 @@
+// minimal hostgen for initramfs and first-boot use: no libc, no stdio, raw
+// syscalls only; supports -p/--platform, -c/--count, -h and -v
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "platforms.h"
+#include "suffix.h"
+
+// long list of names in names.h
+#ifdef WITH_NAMES
+#include "names.h"
+#endif
+
+#define HOSTGEN_VERSION "v0.3a"
+#define NAME_COUNT (sizeof(first_names) / sizeof(first_names[0]))
+
+// getrandom(2) flag; does not block before the kernel's pool is initialized
+#define GRND_INSECURE 4
+#define EINVAL 22
+#define EPIPE 32
+
+#if defined(__x86_64__)
+#define SYS_write 1
+#define SYS_exit_group 231
+#define SYS_getrandom 318
+
+__asm__(".global _start\n"
+        "_start:\n"
+        "    xor %rbp, %rbp\n"
+        "    mov %rsp, %rdi\n"
+        "    and $-16, %rsp\n"
+        "    call tiny_main\n");
+
+static long syscall3(long n, long a, long b, long c) {
+    long ret;
+    __asm__ volatile ("syscall" : "=a"(ret) : "a"(n), "D"(a), "S"(b), "d"(c) : "rcx", "r11", "memory");
+    return ret;
+}
+#elif defined(__aarch64__)
+#define SYS_write 64
+#define SYS_exit_group 94
+#define SYS_getrandom 278
+
+__asm__(".global _start\n"
+        "_start:\n"
+        "    mov x29, #0\n"
+        "    mov x0, sp\n"
+        "    bl tiny_main\n");
+
+static long syscall3(long n, long a, long b, long c) {
+    register long x8 __asm__("x8") = n;
+    register long x0 __asm__("x0") = a;
+    register long x1 __asm__("x1") = b;
+    register long x2 __asm__("x2") = c;
+    __asm__ volatile ("svc 0" : "+r"(x0) : "r"(x8), "r"(x1), "r"(x2) : "memory");
+    return x0;
+}
+#else
+#error "tiny build supports x86_64 and aarch64 only"
+#endif
+
+// output buffer
+static char out_buf[4096];
+static size_t out_len;
+
+// xoshiro256** state
+static uint64_t rng_state[4];
+
+// gcc may emit calls to these even in freestanding code
+void *memcpy(void *dst, const void *src, size_t n) {
+    char *d = dst;
+    const char *s = src;
+    while (n--) *d++ = *s++;
+    return dst;
+}
+
+void *memset(void *dst, int c, size_t n) {
+    char *d = dst;
+    while (n--) *d++ = c;
+    return dst;
+}
+
+__attribute__((noreturn)) static void sys_exit(int status) {
+    syscall3(SYS_exit_group, status, 0, 0);
+    __builtin_unreachable();
+}
+
+// write out the output buffer
+static void flush(void) {
+    size_t off = 0;
+    while (off < out_len) {
+        long ret = syscall3(SYS_write, 1, (long)(out_buf + off), out_len - off);
+        // the reader went away, if SIGPIPE is ignored; that is how endless
+        // runs normally end
+        if (ret == -EPIPE)
+            sys_exit(0);
+        if (ret < 0)
+            sys_exit(1);
+        off += ret;
+    }
+    out_len = 0;
+}
+
+// append a string to the output buffer
+static void put(const char *s) {
+    while (*s) {
+        if (out_len == sizeof(out_buf))
+            flush();
+        out_buf[out_len++] = *s++;
+    }
+}
+
+static bool streq(const char *a, const char *b) {
+    while (*a && *a == *b) a++, b++;
+    return *a == *b;
+}
+
+static bool startswith(const char *s, const char *prefix) {
+    while (*prefix && *s == *prefix) s++, prefix++;
+    return *prefix == '\0';
+}
+
+// seed the rng from getrandom(2)
+static void rng_seed(void) {
+    size_t got = 0;
+    int flags = GRND_INSECURE;
+    while (got < sizeof(rng_state)) {
+        long ret = syscall3(SYS_getrandom, (long)rng_state + got, sizeof(rng_state) - got, flags);
+        // kernels older than 5.6 lack GRND_INSECURE
+        if (ret == -EINVAL && flags != 0) {
+            flags = 0;
+            continue;
+        }
+        if (ret < 0)
+            sys_exit(1);
+        got += ret;
+    }
+    if ((rng_state[0] | rng_state[1] | rng_state[2] | rng_state[3]) == 0)
+        rng_state[0] = 1;
+}
+
+// next output of the xoshiro256** generator
+static uint64_t rng_next(void) {
+    uint64_t *s = rng_state;
+    uint64_t result = s[1] * 5;
+    result = (result << 7 | result >> 57) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = s[3] << 45 | s[3] >> 19;
+    return result;
+}
+
+// uniform random number in [0, bound)
+static inline unsigned int rand_below(unsigned int bound) {
+    uint64_t m = (rng_next() >> 32) * bound;
+    if ((uint32_t)m < bound) {
+        uint32_t threshold = -bound % bound;
+        while ((uint32_t)m < threshold)
+            m = (rng_next() >> 32) * bound;
+    }
+    return m >> 32;
+}
+
+// set platform_type enum, same matching as the full build
+static enum EPlatformType set_platform_type(const char *type_name) {
+    if (startswith(type_name, "macmi")) return MACMINI;
+    if (startswith(type_name, "macbo")) return MACBOOK;
+    if (startswith(type_name, "macst")) return MACSTUDIO;
+    if (startswith(type_name, "mac")) return MAC;
+    if (startswith(type_name, "imac")) return IMAC;
+    if (startswith(type_name, "iph")) return IPHONE;
+    if (startswith(type_name, "ipa")) return IPAD;
+    if (startswith(type_name, "andr")) return ANDROID;
+    if (startswith(type_name, "chrome")) return CHROMEBOOK;
+    if (startswith(type_name, "linux") || startswith(type_name, "ubuntu") || startswith(type_name, "fedora")) return LINUX;
+    if (startswith(type_name, "winse") || startswith(type_name, "winsr")) return WINSERVER;
+    if (startswith(type_name, "win")) return WINDOWS;
+    return ANY;
+}
+
+// ANY and MAC mixes of the platforms compiled in
+static struct platform_mix platform_mix;
+
+// pick a concrete platform for ANY and MAC, among the ones compiled in
+static enum EPlatformType resolve_platform_type(enum EPlatformType platform_type) {
+#ifdef SINGLE_PLATFORM
+    return SINGLE_PLATFORM;
+#else
+    if (platform_type == MAC && platform_mix.mac_len > 0)
+        return platform_mix.mac[rand_below(platform_mix.mac_len)];
+    if (platform_type != ANY && platform_type != MAC && platform_enabled(platform_type))
+        return platform_type;
+    return platform_mix.any[rand_below(platform_mix.any_len)];
+#endif
+}
+
+#if defined(WITH_WINDOWS) || defined(WITH_WINSERVER) || defined(WITH_ANDROID) || defined(WITH_CHROMEBOOK)
+// append count random lowercase hex (base 16) or uppercase base-36 digits,
+// from a single draw unless a base-36 one has to be rejected
+static void put_digits(int count, unsigned int base) {
+    char digits[17];
+    if (base == 16) {
+        hex16(rng_next(), digits, 'a');
+    } else {
+        uint64_t bound = base36_pow[count], threshold = -bound % bound, r;
+        do
+            r = rng_next();
+        while ((uint64_t)((unsigned __int128)r * bound) < threshold);
+        base36_digits(r, count, digits, 'A');
+    }
+    digits[count] = '\0';
+    put(digits);
+}
+#endif
+
+#ifdef WITH_NAMES
+// append a random first name, lowercased if asked
+static void put_name(bool lower) {
+    char name[64];
+    const char *s = first_names[rand_below(NAME_COUNT)];
+    size_t len = 0;
+    for (; *s && len < sizeof(name) - 1; s++)
+        name[len++] = lower && *s >= 'A' && *s <= 'Z' ? *s | 0x20 : *s;
+    name[len] = '\0';
+    put(name);
+}
+#endif
+
+// append one hostname and a newline to the output buffer
+static void put_hostname(enum EPlatformType platform_type) {
+    switch (platform_type) {
+#ifdef WITH_MACBOOK
+        case MACBOOK:
+            put_name(false);
+            put(rand_below(2) == 0 ? "s-Macbook-Air\n" : "s-Macbook-Pro\n");
+            break;
+#endif
+#ifdef WITH_MACMINI
+        case MACMINI:
+            put_name(false);
+            put("s-Mac-Mini\n");
+            break;
+#endif
+#ifdef WITH_IMAC
+        case IMAC:
+            put_name(false);
+            put("s-iMac\n");
+            break;
+#endif
+#ifdef WITH_MACSTUDIO
+        case MACSTUDIO:
+            put_name(false);
+            put("s-Mac-Studio\n");
+            break;
+#endif
+#ifdef WITH_IPHONE
+        case IPHONE:
+            put_name(false);
+            put("s-iPhone\n");
+            break;
+#endif
+#ifdef WITH_IPAD
+        case IPAD:
+            put_name(false);
+            put("s-iPad\n");
+            break;
+#endif
+#ifdef WITH_LINUX
+        case LINUX:
+            put_name(true);
+            put("-");
+            put(linux_models[rand_below(LINUX_MODEL_COUNT)]);
+            put("\n");
+            break;
+#endif
+#ifdef WITH_ANDROID
+        case ANDROID:
+            put("android-");
+            put_digits(16, 16);
+            put("\n");
+            break;
+#endif
+#ifdef WITH_CHROMEBOOK
+        case CHROMEBOOK:
+            put("chromeos-");
+            put_digits(12, 16);
+            put("\n");
+            break;
+#endif
+#ifdef WITH_WINSERVER
+        case WINSERVER:
+            put("WIN-");
+            put_digits(11, 36);
+            put("\n");
+            break;
+#endif
+#ifdef WITH_WINDOWS
+        case WINDOWS:
+            put("DESKTOP-");
+            put_digits(7, 36);
+            put("\n");
+            break;
+#endif
+        default: break;
+    }
+}
+
+// entry point, called from _start with the initial stack pointer
+__attribute__((used, noreturn)) void tiny_main(long *sp) {
+    int argc = sp[0];
+    char **argv = (char **)(sp + 1);
+    const char *platform = "";
+    unsigned long count = 1;
+
+    // parse options: -h, -v, -p PLATFORM, -c COUNT and their long forms
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i], *val = NULL;
+        bool is_short = arg[0] == '-' && arg[1] != '-' && arg[1] != '\0';
+        if (streq(arg, "-h") || streq(arg, "--help")) {
+            put("Usage: hostgen [-p PLATFORM] [-c COUNT]\n"
+                "Platforms: android, chromebook, imac, ipad, iphone, linux, mac, macbook,\n"
+                "           macmini, macstudio, windows, winserver\n");
+            flush();
+            sys_exit(0);
+        }
+        if (streq(arg, "-v") || streq(arg, "--version")) {
+            put("hostgen " HOSTGEN_VERSION " (tiny)\n");
+            flush();
+            sys_exit(0);
+        }
+        if (startswith(arg, "--platform=")) val = arg + 11;
+        else if (startswith(arg, "--count=")) val = arg + 8;
+        else if (is_short && arg[2] != '\0') val = arg + 2;
+        else if (i + 1 < argc) val = argv[++i];
+        else sys_exit(1);
+
+        if ((is_short && arg[1] == 'p') || streq(arg, "--platform") || startswith(arg, "--platform=")) {
+            platform = val;
+        } else if ((is_short && arg[1] == 'c') || streq(arg, "--count") || startswith(arg, "--count=")) {
+            count = 0;
+            if (*val == '\0')
+                sys_exit(1);
+            for (; *val != '\0'; val++) {
+                if (*val < '0' || *val > '9')
+                    sys_exit(1);
+                count = count * 10 + (*val - '0');
+            }
+        } else {
+            sys_exit(1);
+        }
+    }
+
+    rng_seed();
+    platform_mix_init(&platform_mix);
+    enum EPlatformType platform_type = set_platform_type(platform);
+    // a count of 0 is endless, as in the full build
+    for (unsigned long n = 0; count == 0 || n < count; n++)
+        put_hostname(resolve_platform_type(platform_type));
+    flush();
+    sys_exit(0);
+}